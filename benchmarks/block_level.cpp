@@ -0,0 +1,76 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <cstdint>
+
+#include "rmq.hpp"
+
+/*
+ * Compares the block-level structures of RmqSolver on random arrays and
+ * random long queries (at least a half of the array), which always go
+ * through the block level:
+ *   ./block_level [array_size] [queries_num] [block_size]
+*/
+
+namespace {
+
+  using clock_type = std::chrono::steady_clock;
+  using query_type = std::pair<std::size_t, std::size_t>;
+
+  double seconds_since(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+  }
+
+  template <template <typename> class BlockLevel>
+  void run(std::string_view name, const std::vector<std::int32_t> &array,
+           const std::vector<query_type> &queries, std::size_t block_sz) {
+    using solver_type = yLAB::RmqSolver<std::int32_t, std::allocator<std::int32_t>,
+                                        BlockLevel>;
+    auto start = clock_type::now();
+    solver_type solver(array.begin(), array.end(), block_sz);
+    auto build_time = seconds_since(start);
+
+    std::int64_t checksum = 0;
+    start = clock_type::now();
+    for (auto &&query : queries) {
+      checksum += solver.ans_query(query);
+    }
+    auto query_time = seconds_since(start);
+
+    std::cout << std::left << std::setw(20) << name
+              << " build " << std::setw(8) << build_time << " s"
+              << "  query " << std::setw(8) << query_time * 1e9 / queries.size() << " ns"
+              << "  memory " << solver.memory_usage().total() / (1 << 20) << " MB"
+              << "  checksum " << checksum << std::endl;
+  }
+
+} // <--- namespace
+
+int main(int argc, char **argv) {
+  std::size_t size = argc > 1 ? std::stoul(argv[1]) : 10000000;
+  std::size_t queries_num = argc > 2 ? std::stoul(argv[2]) : 10000000;
+  std::size_t block_sz = argc > 3 ? std::stoul(argv[3])
+                                  : yLAB::RmqSolver<int>::theoretical_block_size;
+
+  std::mt19937_64 engine {42};
+  std::vector<std::int32_t> array(size);
+  std::uniform_int_distribution<std::int32_t> value;
+  for (auto &&element : array) {
+    element = value(engine);
+  }
+  std::vector<query_type> queries(queries_num);
+  std::uniform_int_distribution<std::size_t> length(size / 2, size);
+  for (auto &&query : queries) {
+    auto len = length(engine);
+    auto left = std::uniform_int_distribution<std::size_t>(0, size - len)(engine);
+    query = {left, left + len - 1};
+  }
+
+  run<yLAB::BlockSparseTable>("sparse table", array, queries, block_sz);
+  run<yLAB::SuperblockTable>("superblocks", array, queries, block_sz);
+}
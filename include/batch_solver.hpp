@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+
+#include "rmq.hpp"
+#include "parallel.hpp"
+
+namespace yLAB {
+
+template <typename T>
+struct Instance final {
+  std::vector<T> array;
+  std::vector<std::pair<std::size_t, std::size_t>> queries;
+};
+
+/*
+ * Answers the queries of many independent arrays in parallel. Every worker
+ * keeps the tables of its solvers in its own arena which is reset after each
+ * instance, so the tables of small instances don't touch the heap. The
+ * temporary Cartesian tree, its traversal stack and the block minimums of a
+ * build still come from the global heap. Tables of in-block answers are
+ * shared by all the solvers through the process-wide cache.
+*/
+
+template <typename T>
+class BatchSolver final {
+ public:
+  using size_type     = std::size_t;
+  using value_type    = T;
+  using instance_type = Instance<value_type>;
+  using answers_type  = std::vector<value_type>;
+ private:
+  using allocator_type   = std::pmr::polymorphic_allocator<value_type>;
+  using solver_type      = RmqSolver<value_type, allocator_type>;
+ public:
+  // bigger instances continue in the upstream heap
+  static constexpr size_type arena_size = 1 << 20;
+
+  explicit BatchSolver(size_type threads_num = default_threads_number(),
+                       size_type block_sz = solver_type::theoretical_block_size)
+      : threads_num_ {std::max<size_type>(threads_num, 1)}, block_sz_ {block_sz} {}
+
+  std::vector<answers_type> solve(const std::vector<instance_type> &instances) const {
+    std::vector<answers_type> answers(instances.size());
+    std::vector<std::vector<std::byte>> buffers(threads_num_);
+    parallel_for(instances.size(), threads_num_, [&](size_type worker, size_type id) {
+      auto &&[array, queries] = instances[id];
+      auto &buffer = buffers[worker];
+      if (buffer.empty()) {
+        buffer.resize(arena_size);
+      }
+      std::pmr::monotonic_buffer_resource arena {buffer.data(), buffer.size()};
+
+      solver_type solver(array.begin(), array.end(), block_sz_,
+                         allocator_type {&arena});
+      answers[id].reserve(queries.size());
+      for (auto &&query : queries) {
+        answers[id].push_back(solver.ans_query(query));
+      }
+    });
+    return answers;
+  }
+
+ private:
+  size_type threads_num_;
+  size_type block_sz_;
+};
+
+} // <--- namespace yLAB
+
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <atomic>
+
+#include "utils.hpp"
+#include "sparse_table.hpp"
+#include "block_table.hpp"
+#include "memory_usage.hpp"
+
+namespace yLAB {
+
+/*
+ * Block-level structures of RmqSolver: they find the position of the
+ * minimum among the minimums of blocks first_block ... last_block. Both are
+ * built from the positions of the blocks' minimums in the euler tour and
+ * compare them by heights. Lazy structures build their parts on the first
+ * query that needs them, so RmqSolver takes the lazy in-block table with them.
+*/
+
+// The classic sparse table: row i keeps the minimums of 2^j blocks starting
+// at block i.
+template <typename Allocator = std::allocator<std::size_t>>
+class BlockSparseTable final: private SparseTable<std::size_t, Allocator> {
+  using sparse_table = SparseTable<std::size_t, Allocator>;
+  using typename sparse_table::row_type;
+  using sparse_table::sparse_;
+  using sparse_table::rows_memory;
+ public:
+  using size_type      = std::size_t;
+  using allocator_type = Allocator;
+
+  static constexpr bool lazy = false;
+
+  explicit BlockSparseTable(const allocator_type &alloc = allocator_type())
+      : sparse_table(alloc) {}
+
+  template <typename Heights>
+  void build(const std::vector<size_type> &blocks_mins, const Heights &heights) {
+    size_type size = blocks_mins.size();
+    size_type log = log2_floor(size);
+    sparse_.resize(size, row_type(log + 1, sparse_.get_allocator()));
+
+    for (size_type i = 0; i < size; ++i) {
+      sparse_[i][0] = blocks_mins[i];
+    }
+    for (size_type j = 1; j <= log; ++j) {
+      for (size_type i = 0; i < size; ++i) {
+        size_type ind = (size_type{1} << (j - 1)) + i;
+        if (ind >= size) {
+          sparse_[i][j] = sparse_[i][j - 1];
+        }
+        else if (heights[sparse_[i][j - 1]] > heights[sparse_[ind][j - 1]]) {
+          sparse_[i][j] = sparse_[ind][j - 1];
+        }
+        else {
+          sparse_[i][j] = sparse_[i][j - 1];
+        }
+      }
+    }
+  }
+
+  template <typename Heights>
+  size_type min_pos(size_type first_block, size_type last_block,
+                    const Heights &heights) const {
+    auto power = log2_floor(last_block - first_block + 1);
+    auto lhs = sparse_[first_block][power];
+    auto rhs = sparse_[last_block + 1 - (size_type{1} << power)][power];
+    return heights[lhs] < heights[rhs] ? lhs : rhs;
+  }
+
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("block sparse table", rows_memory(sparse_));
+    return usage;
+  }
+
+  static MemoryUsage estimate_memory(size_type blocks_num) {
+    size_type levels_num = blocks_num ? log2_floor(blocks_num) + 1 : 0;
+    MemoryUsage usage;
+    usage.add("block sparse table",
+              blocks_num * (sizeof(row_type) + levels_num * sizeof(size_type)));
+    return usage;
+  }
+};
+
+// Two-level layout. Blocks are grouped in superblocks of 32 blocks, and only
+// the minimums of superblocks get a full sparse table (in one flat array,
+// with the heights next to the positions). Inside a superblock every block
+// keeps a 16-byte record of minimum positions relative to the superblock:
+// the levels of the local sparse table and the prefix and suffix minimums.
+// So a query touches two records, two bases of superblocks and, for queries
+// longer than two superblocks, two cells of the small top table.
+template <typename Allocator = std::allocator<std::size_t>>
+class SuperblockTable final {
+ public:
+  using size_type      = std::size_t;
+  using allocator_type = Allocator;
+ private:
+  using offset_type = std::uint16_t;
+  using record_type = std::array<offset_type, 8>;
+  using top_type    = std::pair<size_type, size_type>; // height and position
+  template <typename U>
+  using vector_type = std::vector<U, typename std::allocator_traits<allocator_type>::
+                                                         template rebind_alloc<U>>;
+
+  static constexpr size_type superblock_log  = 5;
+  static constexpr size_type superblock_size = size_type{1} << superblock_log;
+  // positions in the record: level i of the local sparse table is in slot i
+  static constexpr size_type prefix_slot = superblock_log + 1;
+  static constexpr size_type suffix_slot = superblock_log + 2;
+  // offsets inside a superblock have to fit in offset_type
+  static_assert(BlockTable::max_block_size * superblock_size <=
+                std::numeric_limits<offset_type>::max());
+ public:
+  static constexpr bool lazy = false;
+
+  explicit SuperblockTable(const allocator_type &alloc = allocator_type())
+      : bases_(alloc), records_(alloc), top_(alloc) {}
+
+  template <typename Heights>
+  void build(const std::vector<size_type> &blocks_mins, const Heights &heights) {
+    records_.assign(blocks_mins.size(), {});
+    auto less = [&](size_type lhs, size_type rhs) {
+      return heights[blocks_mins[lhs]] < heights[blocks_mins[rhs]];
+    };
+
+    auto superblocks_num = (blocks_mins.size() + superblock_size - 1) / superblock_size;
+    bases_.resize(superblocks_num);
+    std::vector<size_type> superblocks_mins(superblocks_num);
+    for (size_type superblock = 0; superblock < superblocks_num; ++superblock) {
+      auto first = superblock * superblock_size;
+      auto last  = std::min(blocks_mins.size(), first + superblock_size) - 1;
+      // minimum of the first block precedes the other blocks
+      bases_[superblock] = blocks_mins[first];
+      // minimum blocks are found first, then replaced by the positions
+      for (auto id = first; id <= last; ++id) {
+        records_[id][0] = id - first;
+      }
+      auto block = [first](offset_type offset) { return first + offset; };
+      for (size_type level = 1; level <= superblock_log; ++level) {
+        auto half = size_type{1} << (level - 1);
+        for (auto id = first; id <= last; ++id) {
+          auto lhs = block(records_[id][level - 1]);
+          auto rhs = block(records_[std::min(last, id + half)][level - 1]);
+          records_[id][level] = (less(rhs, lhs) ? rhs : lhs) - first;
+        }
+      }
+      records_[first][prefix_slot] = 0;
+      for (auto id = first + 1; id <= last; ++id) {
+        auto prev = block(records_[id - 1][prefix_slot]);
+        records_[id][prefix_slot] = (less(id, prev) ? id : prev) - first;
+      }
+      records_[last][suffix_slot] = last - first;
+      for (auto id = last; id > first; --id) {
+        auto next = block(records_[id][suffix_slot]);
+        records_[id - 1][suffix_slot] = (less(id - 1, next) ? id - 1 : next) - first;
+      }
+      superblocks_mins[superblock] = blocks_mins[block(records_[first][suffix_slot])];
+      for (auto id = first; id <= last; ++id) {
+        for (auto &&offset : records_[id]) {
+          offset = blocks_mins[block(offset)] - bases_[superblock];
+        }
+      }
+    }
+    build_top(superblocks_mins, heights);
+  }
+
+  template <typename Heights>
+  size_type min_pos(size_type first_block, size_type last_block,
+                    const Heights &heights) const {
+    auto min = [&](size_type lhs, size_type rhs) {
+      return heights[lhs] < heights[rhs] ? lhs : rhs;
+    };
+    auto first_superblock = first_block >> superblock_log;
+    auto last_superblock  = last_block >> superblock_log;
+    if (first_superblock == last_superblock) {
+      auto base  = bases_[first_superblock];
+      auto level = log2_floor(last_block - first_block + 1);
+      auto rhs_block = last_block + 1 - (size_type{1} << level);
+      if (level == 0) {
+        return base + records_[first_block][0];
+      }
+      return min(base + records_[first_block][level], base + records_[rhs_block][level]);
+    }
+    auto answer = min(bases_[first_superblock] + records_[first_block][suffix_slot],
+                      bases_[last_superblock] + records_[last_block][prefix_slot]);
+    if (first_superblock + 1 < last_superblock) {
+      auto level = log2_floor(last_superblock - first_superblock - 1);
+      auto row   = top_.data() + level * bases_.size();
+      auto &&lhs = row[first_superblock + 1];
+      auto &&rhs = row[last_superblock - (size_type{1} << level)];
+      // selections instead of branches: a mispredicted branch on a cache miss
+      // stalls the following queries as well
+      auto top_height   = std::min(lhs.first, rhs.first);
+      auto top_position = (lhs.first < rhs.first ? lhs.second : rhs.second);
+      answer = (top_height < heights[answer] ? top_position : answer);
+    }
+    return answer;
+  }
+
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("superblock bases", MemoryUsage::bytes(bases_));
+    usage.add("in-superblock records", MemoryUsage::bytes(records_));
+    usage.add("superblock sparse table", MemoryUsage::bytes(top_));
+    return usage;
+  }
+
+  static MemoryUsage estimate_memory(size_type blocks_num) {
+    auto superblocks_num = (blocks_num + superblock_size - 1) / superblock_size;
+    size_type levels_num = superblocks_num ? log2_floor(superblocks_num) + 1 : 0;
+    MemoryUsage usage;
+    usage.add("superblock bases", superblocks_num * sizeof(size_type));
+    usage.add("in-superblock records", blocks_num * sizeof(record_type));
+    usage.add("superblock sparse table", levels_num * superblocks_num * sizeof(top_type));
+    return usage;
+  }
+
+ private:
+  // flat sparse table of superblocks, level after level
+  template <typename Heights>
+  void build_top(const std::vector<size_type> &mins, const Heights &heights) {
+    auto size = mins.size();
+    if (size == 0) { return ; }
+
+    size_type levels_num = log2_floor(size) + 1;
+    top_.reserve(levels_num * size);
+    for (auto position : mins) {
+      top_.emplace_back(heights[position], position);
+    }
+    top_.resize(levels_num * size);
+    for (size_type level = 1; level < levels_num; ++level) {
+      auto prev = top_.begin() + (level - 1) * size;
+      auto next = top_.begin() + level * size;
+      auto half = size_type{1} << (level - 1);
+      for (size_type id = 0; id < size; ++id) {
+        next[id] = std::min(prev[id], prev[std::min(size - 1, id + half)]);
+      }
+    }
+  }
+
+ private:
+  vector_type<size_type> bases_;
+  vector_type<record_type> records_;
+  vector_type<top_type> top_;
+};
+
+// The sparse table kept level by level: level 0 (the blocks' minimums) is
+// built eagerly, level j is built from level j - 1 by the first query of
+// 2^j ... 2^(j + 1) - 1 blocks. Level j keeps only the 2^j-block windows which
+// fit into the array. Queries may come from many threads at once.
+template <typename Allocator = std::allocator<std::size_t>>
+class LazyBlockSparseTable final {
+ public:
+  using size_type      = std::size_t;
+  using allocator_type = Allocator;
+ private:
+  using level_type  = std::vector<size_type, allocator_type>;
+  using levels_type = std::vector<level_type, typename std::allocator_traits<
+                                  allocator_type>::template rebind_alloc<level_type>>;
+ public:
+  static constexpr bool lazy = true;
+
+  explicit LazyBlockSparseTable(const allocator_type &alloc = allocator_type())
+      : levels_(alloc) {}
+
+  template <typename Heights>
+  void build(const std::vector<size_type> &blocks_mins, const Heights&) {
+    auto levels_num = levels_number(blocks_mins.size());
+    levels_.assign(levels_num, level_type(levels_.get_allocator()));
+    built_ = std::make_unique<std::once_flag[]>(levels_num);
+    ready_ = std::make_unique<std::atomic<bool>[]>(levels_num);
+    if (levels_num) {
+      levels_.front().assign(blocks_mins.begin(), blocks_mins.end());
+      ready_[0].store(true, std::memory_order_relaxed);
+    }
+  }
+
+  template <typename Heights>
+  size_type min_pos(size_type first_block, size_type last_block,
+                    const Heights &heights) const {
+    auto power = log2_floor(last_block - first_block + 1);
+    auto &&level = this->level(power, heights);
+    auto lhs = level[first_block];
+    auto rhs = level[last_block + 1 - (size_type{1} << power)];
+    return heights[lhs] < heights[rhs] ? lhs : rhs;
+  }
+
+  // levels built so far
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("block sparse table", MemoryUsage::bytes(levels_));
+    for (auto &&level : levels_) {
+      usage.add("block sparse table", MemoryUsage::bytes(level));
+    }
+    return usage;
+  }
+
+  // memory_usage() when all the levels are built
+  static MemoryUsage estimate_memory(size_type blocks_num) {
+    auto levels_num = levels_number(blocks_num);
+    size_type windows = 0;
+    for (size_type level = 0; level < levels_num; ++level) {
+      windows += blocks_num + 1 - (size_type{1} << level);
+    }
+    MemoryUsage usage;
+    usage.add("block sparse table", levels_num * sizeof(level_type) +
+                                    windows * sizeof(size_type));
+    return usage;
+  }
+
+ private:
+  static size_type levels_number(size_type blocks_num) noexcept {
+    return blocks_num ? log2_floor(blocks_num) + 1 : 0;
+  }
+
+  // The missing levels below id are built first, from the lowest one. Once
+  // a level is ready, its queries see a single acquire load.
+  template <typename Heights>
+  const level_type &level(size_type id, const Heights &heights) const {
+    if (ready_[id].load(std::memory_order_acquire)) {
+      return levels_[id];
+    }
+    for (size_type built = 1; built <= id; ++built) {
+      std::call_once(built_[built], [&] {
+        auto &&prev = levels_[built - 1];
+        auto half   = size_type{1} << (built - 1);
+        auto &next  = levels_[built];
+        next.reserve(prev.size() - half);
+        for (size_type block = 0; block + half < prev.size(); ++block) {
+          auto lhs = prev[block], rhs = prev[block + half];
+          next.push_back(heights[rhs] < heights[lhs] ? rhs : lhs);
+        }
+        ready_[built].store(true, std::memory_order_release);
+      });
+    }
+    return levels_[id];
+  }
+
+ private:
+  mutable levels_type levels_;
+  std::unique_ptr<std::once_flag[]> built_;
+  std::unique_ptr<std::atomic<bool>[]> ready_;
+};
+
+} // <--- namespace yLAB
+
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+#include "sparse_table.hpp"
+#include "sparse_table_2d.hpp"
+#include "memory_usage.hpp"
+#include "range_queries.hpp"
+
+namespace yLAB {
+
+/*
+ * Memory-lean variant of SparseTable2D. The matrix is cut into tiles of
+ * tile_sz x tile_sz cells, and only the matrix of tile minimums gets the 2D
+ * sparse table. A query rectangle is split into
+ *  - the rows above and below the whole tiles, each answered with the row's
+ *    1D sparse table of tile minimums and in-tile prefix and suffix minimums;
+ *  - the columns on the left and on the right of the whole tiles, each
+ *    answered with the column's 1D sparse table of tile minimums;
+ *  - the whole tiles, answered with the 2D sparse table.
+ * So a query takes O(tile_sz) lookups, and the memory is
+ * O(nm + nm / tile_sz * log + nm / tile_sz^2 * log^2). A part of a row
+ * inside one tile has no prefix or suffix to use and is scanned: if the
+ * columns of a query fall into one tile, its O(tile_sz) rows take
+ * O(tile_sz^2) time.
+*/
+
+template <typename T, typename Allocator = std::allocator<T>>
+class BlockRmq2D final {
+ public:
+  using size_type      = std::size_t;
+  using value_type     = T;
+  using allocator_type = Allocator;
+  using query_type     = rectangle_query_type;
+ private:
+  template <typename U>
+  using rebind_alloc = typename std::allocator_traits<allocator_type>::
+                                                      template rebind_alloc<U>;
+  using matrix_type  = std::vector<value_type, allocator_type>;
+  using line_type    = SparseTable<value_type, allocator_type>;
+  using lines_type   = std::vector<line_type, rebind_alloc<line_type>>;
+  using tiles_type   = SparseTable2D<value_type, allocator_type>;
+ public:
+  static constexpr size_type default_tile_size = 16;
+
+  // row-major matrix with cols columns
+  template <std::input_iterator Iter>
+  BlockRmq2D(Iter begin, Iter end, size_type cols,
+             size_type tile_sz = default_tile_size,
+             const allocator_type &alloc = allocator_type())
+      : matrix_(alloc), row_prefix_(alloc), row_suffix_(alloc),
+        row_tiles_(alloc), col_tiles_(alloc), tiles_(alloc), tile_sz_ {tile_sz} {
+    if (tile_sz_ == 0) {
+      throw std::invalid_argument {"tile size must be positive"};
+    }
+    matrix_.assign(begin, end);
+    if (matrix_.empty()) { return ; }
+    if (cols == 0 || matrix_.size() % cols) {
+      throw std::invalid_argument {std::to_string(matrix_.size()) +
+                                   " elements don't make a matrix with " +
+                                   std::to_string(cols) + " columns"};
+    }
+    rows_ = matrix_.size() / cols, cols_ = cols;
+    build();
+  }
+
+  value_type ans_query(const query_type &query) const {
+    auto [rows, cols] = query;
+    if (rows.first > rows.second) { std::swap(rows.first, rows.second); }
+    if (cols.first > cols.second) { std::swap(cols.first, cols.second); }
+
+    auto [first_row, last_row] = rows;
+    auto first_tile = first_row / tile_sz_, last_tile = last_row / tile_sz_;
+    auto answer = matrix_[first_row * cols_ + cols.first];
+    auto add_rows = [&](size_type first, size_type last) {
+      for (auto row = first; row <= last; ++row) {
+        answer = std::min(answer, row_min(row, cols));
+      }
+    };
+    if (last_tile - first_tile < 2) {
+      add_rows(first_row, last_row);
+      return answer;
+    }
+    add_rows(first_row, (first_tile + 1) * tile_sz_ - 1);
+    add_rows(last_tile * tile_sz_, last_row);
+
+    // the band of whole tiles of rows
+    range_query_type band {first_tile + 1, last_tile - 1};
+    auto add_cols = [&](size_type first, size_type last) {
+      for (auto col = first; col <= last; ++col) {
+        answer = std::min(answer, col_tiles_[col].min(band));
+      }
+    };
+    auto first_col_tile = cols.first / tile_sz_, last_col_tile = cols.second / tile_sz_;
+    if (last_col_tile - first_col_tile < 2) {
+      add_cols(cols.first, cols.second);
+      return answer;
+    }
+    add_cols(cols.first, (first_col_tile + 1) * tile_sz_ - 1);
+    add_cols(last_col_tile * tile_sz_, cols.second);
+    return std::min(answer, tiles_.ans_query({band, {first_col_tile + 1,
+                                                      last_col_tile - 1}}));
+  }
+
+  size_type rows() const noexcept { return rows_; }
+  size_type cols() const noexcept { return cols_; }
+  size_type tile_size() const noexcept { return tile_sz_; }
+
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("matrix", MemoryUsage::bytes(matrix_));
+    usage.add("in-tile minimums", MemoryUsage::bytes(row_prefix_) +
+                                  MemoryUsage::bytes(row_suffix_));
+    usage.add("lines of tiles", MemoryUsage::bytes(row_tiles_) +
+                                MemoryUsage::bytes(col_tiles_));
+    for (auto &&lines : {&row_tiles_, &col_tiles_}) {
+      for (auto &&line : *lines) {
+        usage.add("lines of tiles", line.memory_usage().total());
+      }
+    }
+    usage.add(tiles_.memory_usage());
+    return usage;
+  }
+
+  // memory_usage() of rows x cols matrix
+  static MemoryUsage estimate_memory(size_type rows, size_type cols,
+                                     size_type tile_sz = default_tile_size) {
+    MemoryUsage usage;
+    auto cells = rows * cols * sizeof(value_type);
+    usage.add("matrix", cells);
+    usage.add("in-tile minimums", 2 * cells);
+    if (cells == 0) {
+      usage.add("lines of tiles", 0);
+      usage.add(tiles_type::estimate_memory(0, 0));
+      return usage;
+    }
+    auto row_tiles = (cols + tile_sz - 1) / tile_sz;
+    auto col_tiles = (rows + tile_sz - 1) / tile_sz;
+    usage.add("lines of tiles", (rows + cols) * sizeof(line_type) +
+              rows * line_type::estimate_memory(row_tiles).total() +
+              cols * line_type::estimate_memory(col_tiles).total());
+    usage.add(tiles_type::estimate_memory(col_tiles, row_tiles));
+    return usage;
+  }
+
+ private:
+  value_type row_min(size_type row, const range_query_type &cols) const {
+    auto first_tile = cols.first / tile_sz_, last_tile = cols.second / tile_sz_;
+    auto line = matrix_.begin() + row * cols_;
+    if (first_tile == last_tile) {
+      return *std::min_element(line + cols.first, line + cols.second + 1);
+    }
+    auto answer = std::min(row_suffix_[row * cols_ + cols.first],
+                           row_prefix_[row * cols_ + cols.second]);
+    if (first_tile + 1 < last_tile) {
+      answer = std::min(answer, row_tiles_[row].min({first_tile + 1, last_tile - 1}));
+    }
+    return answer;
+  }
+
+  void build() {
+    auto row_tiles = (cols_ + tile_sz_ - 1) / tile_sz_;
+    auto col_tiles = (rows_ + tile_sz_ - 1) / tile_sz_;
+    row_prefix_ = row_suffix_ = matrix_;
+    std::vector<value_type> line(row_tiles);
+    std::vector<value_type> tiles(row_tiles * col_tiles);
+    row_tiles_.reserve(rows_);
+    for (size_type row = 0; row < rows_; ++row) {
+      auto prefix = row_prefix_.begin() + row * cols_;
+      auto suffix = row_suffix_.begin() + row * cols_;
+      for (size_type tile = 0; tile < row_tiles; ++tile) {
+        auto first = tile * tile_sz_, last = std::min(cols_, first + tile_sz_) - 1;
+        for (auto col = first + 1; col <= last; ++col) {
+          prefix[col] = std::min(prefix[col], prefix[col - 1]);
+        }
+        for (auto col = last; col > first; --col) {
+          suffix[col - 1] = std::min(suffix[col - 1], suffix[col]);
+        }
+        line[tile] = suffix[first];
+        auto &tile_min = tiles[row / tile_sz_ * row_tiles + tile];
+        tile_min = (row % tile_sz_ == 0 ? line[tile] : std::min(tile_min, line[tile]));
+      }
+      row_tiles_.emplace_back(line.begin(), line.end(), line.size(),
+                              matrix_.get_allocator());
+    }
+
+    line.resize(col_tiles);
+    col_tiles_.reserve(cols_);
+    for (size_type col = 0; col < cols_; ++col) {
+      for (size_type row = 0; row < rows_; ++row) {
+        auto value = matrix_[row * cols_ + col];
+        line[row / tile_sz_] = (row % tile_sz_ == 0 ? value
+                                                    : std::min(line[row / tile_sz_], value));
+      }
+      col_tiles_.emplace_back(line.begin(), line.end(), line.size(),
+                              matrix_.get_allocator());
+    }
+    tiles_ = tiles_type(tiles.begin(), tiles.end(), row_tiles, matrix_.get_allocator());
+  }
+
+ private:
+  matrix_type matrix_;
+  // minimums from the beginning of the tile to the cell and from the cell
+  // to the end of the tile in the same row
+  matrix_type row_prefix_;
+  matrix_type row_suffix_;
+  lines_type row_tiles_;
+  lines_type col_tiles_;
+  tiles_type tiles_;
+  size_type tile_sz_;
+  size_type rows_ {0};
+  size_type cols_ {0};
+};
+
+template <std::input_iterator Iter>
+BlockRmq2D(Iter, Iter, std::size_t) ->
+                    BlockRmq2D<typename std::iterator_traits<Iter>::value_type>;
+
+template <std::input_iterator Iter>
+BlockRmq2D(Iter, Iter, std::size_t, std::size_t) ->
+                    BlockRmq2D<typename std::iterator_traits<Iter>::value_type>;
+
+} // <--- namespace yLAB
+
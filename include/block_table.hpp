@@ -0,0 +1,229 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <bitset>
+#include <memory>
+#include <vector>
+#include <string>
+#include <limits>
+#include <climits>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <stdexcept>
+
+namespace yLAB {
+
+namespace detail {
+
+  // the table of block_sz, built by the first caller and shared by the others
+  template <typename Table>
+  typename Table::pointer shared_table(std::size_t block_sz) {
+    static std::mutex tables_mutex;
+    static std::map<std::size_t, typename Table::pointer> tables;
+
+    std::lock_guard lock {tables_mutex};
+    auto &table = tables[block_sz];
+    if (!table) {
+      table = std::make_shared<const Table>(block_sz);
+    }
+    return table;
+  }
+
+} // <--- namespace detail
+
+/*
+ * Answers of all in-block queries for all 2^(block_sz - 1) types of blocks
+ * of the +-1 sequence: block type is a bit mask, where bit i is set if the
+ * element i + 1 is bigger than the element i. The table depends only on the
+ * block size, so it's computed once per process and shared by all solvers.
+*/
+
+class BlockTable final {
+ public:
+  using size_type     = std::size_t;
+  using position_type = std::uint8_t;
+  using block_bits    = std::bitset<sizeof(size_type) * CHAR_BIT>;
+  using pointer       = std::shared_ptr<const BlockTable>;
+
+  // block type is a bit mask of block_sz - 1 steps
+  static constexpr size_type max_block_size = block_bits().size();
+
+  explicit BlockTable(size_type block_sz)
+      : block_sz_ {block_sz} {
+    check_block_size(block_sz);
+    precompute_all_blocks_rmq();
+  }
+
+  // the table of block_sz, built by the first caller
+  static pointer get(size_type block_sz) {
+    return detail::shared_table<BlockTable>(block_sz);
+  }
+
+  static void check_block_size(size_type block_sz) {
+    if (block_sz == 0 || memory(block_sz) == std::numeric_limits<size_type>::max()) {
+      throw std::length_error {"in-block table is too large for block size " +
+                               std::to_string(block_sz)};
+    }
+  }
+
+  // size in bytes of the table, max() if it doesn't fit in size_type
+  static constexpr size_type memory(size_type block_sz) noexcept {
+    constexpr auto max = std::numeric_limits<size_type>::max();
+    if (block_sz - 1 >= block_bits().size()) { return max; }
+
+    size_type memory = size_type{1} << (block_sz - 1);
+    for (size_type factor : {block_sz, block_sz, sizeof(position_type)}) {
+      if (memory > max / factor) { return max; }
+      memory *= factor;
+    }
+    return memory;
+  }
+
+  // position of the minimum on [l, r] inside the block of block_type
+  size_type min_pos(size_type block_type, size_type l, size_type r) const noexcept {
+    return table_[(block_type * block_sz_ + l) * block_sz_ + r];
+  }
+
+  size_type block_size() const noexcept { return block_sz_; }
+
+  // bytes taken by the table, equal to memory(block_size())
+  size_type memory_usage() const noexcept { return table_.capacity() * sizeof(position_type); }
+
+  // writes block_sz x block_sz answers of the block of block_type to mins
+  template <typename Iter>
+  static void precompute_block_rmq(size_type block_sz, size_type block_type, Iter mins) {
+    auto section = get_block_section(block_sz, block_type);
+    for (size_type j = 0; j < block_sz; ++j, mins += block_sz) {
+      auto min = section[j];
+      size_type min_id = j;
+      mins[j] = j;
+      for (size_type k = j + 1; k < block_sz; ++k) {
+        if (min < section[k]) {
+          mins[k] = min_id;
+        } else {
+          mins[k] = min_id = k;
+          min = section[min_id];
+        }
+      }
+    }
+  }
+
+ private:
+  void precompute_all_blocks_rmq() {
+    // we have 2^(block_sz - 1)  different blocks
+    size_type diff_blocks = size_type{1} << (block_sz_ - 1);
+    table_.resize(diff_blocks * block_sz_ * block_sz_);
+    for (size_type i = 0; i < diff_blocks; ++i) {
+      precompute_block_rmq(block_sz_, i, table_.begin() + i * block_sz_ * block_sz_);
+    }
+  }
+
+  static std::vector<std::ptrdiff_t> get_block_section(size_type block_sz,
+                                                       size_type block_id) {
+    block_bits b_set(block_id);
+    std::vector<std::ptrdiff_t> section(block_sz, 0);
+    std::ptrdiff_t assign = 0;
+    for (size_type i = 1; i < block_sz; ++i) {
+      if (b_set[i - 1] == 0) {
+        section[i] = --assign;
+      } else {
+        section[i] = ++assign;
+      }
+    }
+    return section;
+  }
+
+ private:
+  size_type block_sz_;
+  std::vector<position_type> table_;
+};
+
+/*
+ * The same answers as in BlockTable, but the answers of a block type are
+ * computed when the first query comes to a block of this type. Until then
+ * the type costs one null pointer. Concurrent queries may both compute the
+ * same type, only one of the results is published.
+*/
+
+class LazyBlockTable final {
+ public:
+  using size_type     = std::size_t;
+  using position_type = BlockTable::position_type;
+  using pointer       = std::shared_ptr<const LazyBlockTable>;
+
+  static constexpr size_type max_block_size = BlockTable::max_block_size;
+
+  explicit LazyBlockTable(size_type block_sz)
+      : block_sz_ {block_sz} {
+    BlockTable::check_block_size(block_sz);
+    types_ = std::make_unique<std::atomic<const position_type*>[]>(types_number());
+  }
+
+  LazyBlockTable(const LazyBlockTable&) = delete;
+  LazyBlockTable &operator=(const LazyBlockTable&) = delete;
+
+  ~LazyBlockTable() {
+    for (size_type type = 0; type < types_number(); ++type) {
+      delete[] types_[type].load(std::memory_order_relaxed);
+    }
+  }
+
+  // the table of block_sz, built by the first caller
+  static pointer get(size_type block_sz) {
+    return detail::shared_table<LazyBlockTable>(block_sz);
+  }
+
+  // size in bytes when all the types are computed, max() if it doesn't fit
+  static constexpr size_type memory(size_type block_sz) noexcept {
+    constexpr auto max = std::numeric_limits<size_type>::max();
+    auto table_memory = BlockTable::memory(block_sz);
+    if (table_memory == max) { return max; }
+
+    auto pointers_memory = (size_type{1} << (block_sz - 1)) *
+                           sizeof(std::atomic<const position_type*>);
+    return table_memory > max - pointers_memory ? max : table_memory + pointers_memory;
+  }
+
+  // position of the minimum on [l, r] inside the block of block_type
+  size_type min_pos(size_type block_type, size_type l, size_type r) const {
+    auto mins = types_[block_type].load(std::memory_order_acquire);
+    if (!mins) [[unlikely]] {
+      mins = precompute_type(block_type);
+    }
+    return mins[l * block_sz_ + r];
+  }
+
+  size_type block_size() const noexcept { return block_sz_; }
+
+  // bytes taken by the pointers and by the types computed so far
+  size_type memory_usage() const noexcept {
+    return types_number() * sizeof(types_[0]) +
+           built_.load(std::memory_order_relaxed) * block_sz_ * block_sz_ *
+           sizeof(position_type);
+  }
+
+ private:
+  size_type types_number() const noexcept { return size_type{1} << (block_sz_ - 1); }
+
+  const position_type *precompute_type(size_type block_type) const {
+    auto mins = std::make_unique<position_type[]>(block_sz_ * block_sz_);
+    BlockTable::precompute_block_rmq(block_sz_, block_type, mins.get());
+    const position_type *published = nullptr;
+    if (types_[block_type].compare_exchange_strong(published, mins.get(),
+                                                   std::memory_order_acq_rel)) {
+      built_.fetch_add(1, std::memory_order_relaxed);
+      return mins.release();
+    }
+    return published;
+  }
+
+ private:
+  size_type block_sz_;
+  std::unique_ptr<std::atomic<const position_type*>[]> types_;
+  mutable std::atomic<size_type> built_ {0};
+};
+
+} // <--- namespace yLAB
+
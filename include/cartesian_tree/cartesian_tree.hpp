@@ -3,12 +3,14 @@
 #include <memory>
 #include <vector>
 #include <stack>
-#include <queue>
 #include <iterator>
+#include <algorithm>
+#include <functional>
 #include <concepts>
 #include <cstddef>
 #include <initializer_list>
 #include <utility>
+#include <stdexcept>
 
 #include "node.hpp"
 #include "iterator.hpp"
@@ -17,12 +19,25 @@ namespace yLAB {
 
 namespace dt = detail;
 
-template <typename> class RmqSolver;
+template <typename, typename, template <typename> class> class RmqSolver;
 
 /*
- * This Treap class contains an incomplete interface (or rather,
- * it is completely absent). Its main purpose is to simply build
- * a Cartesian tree and be able to traverse it in the RmqSolver class.
+ * Cartesian tree of a sequence with implicit keys: the key of an element is
+ * its position, the priority is its value, and the last minimum is the
+ * root. The tree is built in O(n) from a range, nodes aren't inserted or
+ * erased one by one:
+ *  - root() gives the root node for walks over the links of the nodes;
+ *  - begin() and end() iterate the nodes in the order of keys;
+ *  - size() and empty() count the nodes;
+ *  - merge() and split() join and cut trees of adjacent segments. Keys
+ *    start from first_key, so the tree of a segment starting at position p
+ *    is built with first_key = p and merges with the tree of the segment
+ *    before it.
+ * Copies are deep, moves and swaps are O(1).
+ *
+ * Nodes live in chunks of contiguous memory, and the chunks are listed in
+ * storage_ in the order of keys: the nodes of a tree are exactly the nodes
+ * of its spans, sorted by key. Split trees share the chunk they were cut in.
 */
 
 template <typename T>
@@ -42,38 +57,38 @@ class Treap final {
   using reverse_iterator       = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
  private:
-  using base_node = node_type::base_node;
+  using node_pointer = typename node_type::node_pointer;
+  using span_type    = dt::Span<node_type>;
+  using chunk_type   = typename span_type::chunk_type;
 
-  using node_pointer      = typename base_node::node_pointer;
-  using base_node_pointer = typename base_node::base_node_pointer;
+  static constexpr size_type min_chunk_size = 64;
  public:
 
-  constexpr Treap()
-      : end_node_ {create_node<base_node>(root_)} {}
+  Treap() = default;
 
   Treap(std::initializer_list<value_type> i_list)
       : Treap(i_list.begin(), i_list.end()) {}
 
-  // Complexity O(n)
+  // Complexity O(n), keys are first_key, first_key + 1, ...
   template <std::input_iterator Iter>
   requires requires(Iter it) { {*it} -> std::convertible_to<value_type>; }
-  Treap(Iter begin, Iter end)
-      : end_node_ {create_node<base_node>(root_)} {
+  Treap(Iter begin, Iter end, key_type first_key = 0)
+      : Treap() {
     if (begin == end) return ;
+    if constexpr (std::forward_iterator<Iter>) {
+      add_chunk(std::distance(begin, end));
+    }
 
-    std::stack<node_pointer> build_nodes;
-    root_ = create_node<node_type>(0, *(begin++));
+    std::stack<node_pointer, std::vector<node_pointer>> build_nodes;
+    root_ = create_node(first_key, *(begin++));
     build_nodes.push(root_);
-    for (size_type order_num {1}; begin != end; ++begin) {
+    for (key_type order_num {first_key + 1}; begin != end; ++begin) {
       node_pointer top = nullptr;
       while (!build_nodes.empty()) {
         top = build_nodes.top();
         if (top->priority() < *begin) {
-          auto new_node = create_node<node_type>(order_num++, *begin, nullptr,
-                                                 top->right(), top);
-          if (top->right()) {
-            top->right()->parent() = new_node;
-          }
+          auto new_node = create_node(order_num++, *begin, nullptr,
+                                      top->right());
           top->right() = new_node;
           build_nodes.push(new_node);
           break;
@@ -81,53 +96,52 @@ class Treap final {
         build_nodes.pop();
       }
       if (build_nodes.empty()) {
-        build_nodes.push(create_node<node_type>(order_num++, *begin, nullptr,
-                                                top, nullptr));
-        top->parent() = build_nodes.top();
-        root_ = static_cast<node_pointer>(top->parent());
+        root_ = create_node(order_num++, *begin, nullptr, top);
+        build_nodes.push(root_);
       }
     }
-    make_root_links();
   }
 
+  // Complexity O(n), a single allocation. Contiguous nodes are copied as
+  // they are and only their links are shifted.
   Treap(const Treap &rhs)
-      : end_node_ {create_node<base_node>(root_)} {
-    if (!rhs.size()) { return ; }
- 
-    root_ = create_node<node_type>(rhs.root_->key(), rhs.root_->priority());
-
-    // level tree traversal nodes
-    std::queue<node_pointer> rhs_nodes;
-    // creating nodes
-    std::queue<node_pointer> nodes;
-
-    rhs_nodes.push(rhs.root_);
-    nodes.push(root_);
-    while(rhs_nodes.size()) {
-      auto parent   = nodes.front();
-      auto rhs_node = rhs_nodes.front();
-      if (rhs_node->left()) {
-        parent->left() = create_node<node_type>(rhs_node->left()->key(),
-                                                rhs_node->left()->priority());
-        parent->left()->parent() = parent;
-        rhs_nodes.push(rhs_node->left());
-        nodes.push(parent->left());
-      }
-      if (rhs_node->right()) {
-        parent->right() = create_node<node_type>(rhs_node->right()->key(),
-                                                 rhs_node->right()->priority());
-        parent->right()->parent() = parent;
-        rhs_nodes.push(rhs_node->right());
-        nodes.push(parent->right());
-      }
-      rhs_nodes.pop();
-      nodes.pop();
+      : Treap() {
+    if (rhs.empty()) { return ; }
+
+    // old spans sorted by address with their offsets in the new chunk
+    std::vector<std::pair<node_pointer, difference_type>> spans;
+    spans.reserve(rhs.storage_.size());
+    add_chunk(rhs.size_);
+    auto &chunk = *storage_.back().chunk;
+    for (auto &&span : rhs.storage_) {
+      spans.emplace_back(span.first, chunk.size());
+      chunk.insert(chunk.end(), span.first, span.last);
+    }
+    storage_.back().last += rhs.size_;
+    size_ = rhs.size_;
+    auto by_address = [](auto &&lhs, auto &&rhs) {
+      return std::less<node_pointer>{}(lhs.first, rhs.first);
+    };
+    std::sort(spans.begin(), spans.end(), by_address);
+
+    auto new_pointer = [&](node_pointer node) -> node_pointer {
+      if (!node) { return nullptr; }
+      auto span = std::prev(std::upper_bound(spans.begin(), spans.end(),
+                                             std::make_pair(node, difference_type{0}),
+                                             by_address));
+      return chunk.data() + span->second + (node - span->first);
+    };
+    for (auto &&node : chunk) {
+      node.left()  = new_pointer(node.left());
+      node.right() = new_pointer(node.right());
     }
-    make_root_links();
+    root_ = new_pointer(rhs.root_);
+  }
+
+  Treap(Treap &&rhs) noexcept {
+    swap(rhs);
   }
-  
-  Treap(Treap &&rhs) = default;
-  
+
   Treap &operator=(const Treap &rhs) {
     if (this == std::addressof(rhs)) {
       return *this;
@@ -145,27 +159,94 @@ class Treap final {
 
   ~Treap() = default;
 
-  // it works only if all keys in right are bigger than in left
-  static Treap merge(const Treap &left, const Treap &right) {
-    Treap result;
-    result.root_ = result.merge_impl(left.root_, right.root_);
-    result.make_root_links();
+  // All keys in right must be bigger than in left, std::invalid_argument
+  // otherwise. Complexity O(depth), no allocations of nodes: the right spine
+  // of left and the left spine of right are zipped in the order of priorities.
+  static Treap merge(Treap left, Treap right) {
+    if (right.empty()) { return left; }
+    if (left.empty())  { return right; }
+    // spans are sorted by keys, so the extreme keys are at their ends
+    if (!((left.storage_.back().last - 1)->key() < right.storage_.front().first->key())) {
+      throw std::invalid_argument {"merged trees have overlapping keys"};
+    }
+
+    node_pointer lhs = left.root_, rhs = right.root_;
+    node_pointer root   = nullptr;
+    node_pointer *link  = &root;
+    while (lhs && rhs) {
+      if (lhs->priority() < rhs->priority()) {
+        *link = lhs;
+        link  = &std::exchange(lhs, lhs->right())->right();
+      } else {
+        *link = rhs;
+        link  = &std::exchange(rhs, rhs->left())->left();
+      }
+    }
+    *link = (lhs ? lhs : rhs);
+
+    left.root_  = root;
+    left.size_ += right.size_;
+    left.storage_.insert(left.storage_.end(), right.storage_.begin(),
+                         right.storage_.end());
+    return left;
+  }
 
+  // Splits tree into the trees with keys <= key and keys > key.
+  // Complexity O(depth + log n), no allocations of nodes.
+  static std::pair<Treap, Treap> split(Treap tree, key_type key) {
+    std::pair<Treap, Treap> result;
+    auto &&[left, right] = result;
+
+    node_pointer *left_link = &left.root_, *right_link = &right.root_;
+    for (auto node = tree.root_; node;) {
+      if (node->key() <= key) {
+        *left_link = node;
+        left_link  = &std::exchange(node, node->right())->right();
+      } else {
+        *right_link = node;
+        right_link  = &std::exchange(node, node->left())->left();
+      }
+    }
+    *left_link = *right_link = nullptr;
+
+    // spans are sorted by keys, so the border is found with binary searches
+    auto &storage = tree.storage_;
+    auto border = std::partition_point(storage.begin(), storage.end(),
+                                       [key](auto &&span) {
+                                         return (span.last - 1)->key() <= key;
+                                       });
+    left.storage_.assign(storage.begin(), border);
+    if (border != storage.end()) {
+      auto middle = std::partition_point(border->first, border->last,
+                                         [key](auto &&node) {
+                                           return node.key() <= key;
+                                         });
+      if (middle != border->first) {
+        left.storage_.push_back({border->chunk, border->first, middle});
+      }
+      right.storage_.push_back({border->chunk, middle, border->last});
+      right.storage_.insert(right.storage_.end(), std::next(border), storage.end());
+    }
+    for (auto &&part : {&left, &right}) {
+      for (auto &&span : part->storage_) {
+        part->size_ += span.size();
+      }
+    }
     return result;
   }
 
   void swap(Treap &rhs) noexcept {
     std::swap(root_, rhs.root_);
-    std::swap(begin_node_, rhs.begin_node_);
-    std::swap(end_node_, rhs.end_node_);
+    std::swap(size_, rhs.size_);
     storage_.swap(rhs.storage_);
   }
 
-  size_type size() const noexcept { return storage_.size() - 1; }
-  [[nodiscard]] bool empty() const noexcept { return storage_.size() - 1 == 0; }
+  size_type size() const noexcept { return size_; }
+  const_pointer root() const noexcept { return root_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
 
-  iterator begin() const noexcept { return {begin_node_}; }
-  iterator end()   const noexcept { return {end_node_};   }
+  iterator begin() const noexcept { return {storage_.data(), spans_end()}; }
+  iterator end()   const noexcept { return {spans_end(), spans_end()};   }
   const_iterator cbegin() const noexcept { return begin(); }
   const_iterator cend()   const noexcept { return end();   }
   reverse_iterator rbegin() const { return std::make_reverse_iterator(end());   }
@@ -173,61 +254,42 @@ class Treap final {
   const_reverse_iterator crbegin() const { return rbegin(); }
   const_reverse_iterator crend()   const { return rbegin(); }
  private:
-
-  void make_root_links() noexcept {
-    end_node_->left() = root_;
-	  if (root_) {
-      root_->parent() = end_node_;
-      begin_node_     = node_type::get_most_left(root_);
-	  }
+  const span_type *spans_end() const noexcept {
+    return storage_.data() + storage_.size();
   }
 
-  template <typename NodeType, typename... Args>
-  NodeType *create_node(Args&&... args) {
-    auto un_ptr = std::make_unique<NodeType>(std::forward<Args>(args)...);
-    storage_.push_back(std::move(un_ptr));
-    return static_cast<NodeType*>(storage_.back().get());
+  void add_chunk(size_type capacity) {
+    auto chunk = std::make_shared<chunk_type>();
+    chunk->reserve(capacity);
+    storage_.push_back({chunk, chunk->data(), chunk->data()});
   }
 
-  node_pointer merge_impl(node_pointer left, node_pointer right) {
-    if (!left)  { return right; }
-    if (!right) { return left;  }
-
-    if (left->priority() < right->priority()) {
-      auto new_right = merge_impl(left->right(), right);
-      return create_node<node_type>(left->key(), left->priority(), new_right,
-                                      left->left(), left);
-    }
-    auto new_left = merge_impl(left, right->left());
-    return create_node<node_type>(right->key(), right->priority(), right->right(),
-                                  new_left, right);
-  }
-
-  std::pair<node_pointer, node_pointer> split(node_pointer node, size_type key) {
-    if (!node) { return {nullptr, nullptr}; }
-
-    if (node->key() <= key) {
-      auto [left, right] = split(node->right(), key);
-      node->right() = left;
-      return {node, right};
-    } else {
-      auto [left, right] = split(node->left(), key);
-      node->left() = right;
-      return {left, node};
+  // nodes are created in the order of keys
+  template <typename... Args>
+  node_pointer create_node(Args&&... args) {
+    if (storage_.empty() ||
+        storage_.back().chunk->size() == storage_.back().chunk->capacity()) {
+      add_chunk(std::max(min_chunk_size, size_));
     }
+    auto &span = storage_.back();
+    span.chunk->emplace_back(std::forward<Args>(args)...);
+    ++size_;
+    return span.last++;
   }
 
-  template <typename> friend class RmqSolver;
+  template <typename, typename, template <typename> class> friend class RmqSolver;
  private:
-  std::vector<std::unique_ptr<base_node>> storage_;
+  std::vector<span_type> storage_;
+  size_type size_ {0};
 
   node_pointer root_ {nullptr};
-  base_node_pointer end_node_;
-  base_node_pointer begin_node_ {end_node_};
 };
 
 template <std::input_iterator Iter>
 Treap(Iter, Iter) -> Treap<typename std::iterator_traits<Iter>::value_type>;
 
+template <std::input_iterator Iter>
+Treap(Iter, Iter, std::size_t) -> Treap<typename std::iterator_traits<Iter>::value_type>;
+
 } // <--- namespace yLAB
 
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <vector>
+#include <ranges>
+#include <string>
+#include <random>
+#include <limits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace yLAB {
+
+/*
+ * Dynamic counterpart of RmqSolver: a sequence with insertions and erasures
+ * at any position and range-minimum queries, all in O(log n) expected time.
+ * Unlike Treap, whose priorities are the values themselves (so a sorted array
+ * gives a path), priorities here are random and the values are kept in the
+ * nodes together with the size and the minimum of their subtrees. A node's
+ * position in the sequence is its implicit key: the size of everything on
+ * the left of it.
+*/
+
+template <typename T>
+class ImplicitTreap final {
+ public:
+  using size_type  = std::size_t;
+  using value_type = T;
+ private:
+  using priority_type = std::uint32_t;
+
+  static constexpr size_type null = std::numeric_limits<size_type>::max();
+
+  struct Node final {
+    value_type value;
+    value_type min;
+    size_type size;
+    size_type left;
+    size_type right;
+    priority_type priority;
+  };
+ public:
+
+  ImplicitTreap() = default;
+
+  ImplicitTreap(std::initializer_list<value_type> i_list)
+      : ImplicitTreap(i_list.begin(), i_list.end()) {}
+
+  // Complexity O(n): the tree is built over the sequence with a stack,
+  // like a Cartesian tree of the random priorities
+  template <std::input_iterator Iter>
+  ImplicitTreap(Iter begin, Iter end) {
+    if constexpr (std::forward_iterator<Iter>) {
+      nodes_.reserve(std::distance(begin, end));
+    }
+    std::vector<size_type> build_nodes;
+    for (; begin != end; ++begin) {
+      auto new_node = create_node(*begin);
+      auto last     = null;
+      while (!build_nodes.empty() &&
+             nodes_[build_nodes.back()].priority < nodes_[new_node].priority) {
+        last = build_nodes.back();
+        build_nodes.pop_back();
+        // the subtree of the popped node won't change anymore
+        update(last);
+      }
+      nodes_[new_node].left = last;
+      if (!build_nodes.empty()) {
+        nodes_[build_nodes.back()].right = new_node;
+      }
+      build_nodes.push_back(new_node);
+    }
+    for (auto node : build_nodes | std::views::reverse) {
+      update(node);
+    }
+    root_ = build_nodes.empty() ? null : build_nodes.front();
+  }
+
+  // inserts value before the element at pos
+  void insert(size_type pos, const value_type &value) {
+    check_position(pos, size() + 1);
+    auto [left, right] = split(root_, pos);
+    root_ = merge(merge(left, create_node(value)), right);
+  }
+
+  void push_back(const value_type &value) { insert(size(), value); }
+
+  void erase(size_type pos) {
+    check_position(pos, size());
+    auto [left, right]     = split(root_, pos);
+    auto [erased, remains] = split(right, 1);
+    free_.push_back(erased);
+    root_ = merge(left, remains);
+  }
+
+  // minimum on [query.first, query.second]
+  value_type range_min(const std::pair<size_type, size_type> &query) const {
+    auto [l, r] = query;
+    if (l > r) {
+      std::swap(l, r);
+    }
+    check_position(r, size());
+    return range_min(root_, l, r);
+  }
+
+  const value_type &operator[](size_type pos) const {
+    auto node = root_;
+    for (;;) {
+      auto left_size = get_size(nodes_[node].left);
+      if (pos == left_size) {
+        return nodes_[node].value;
+      }
+      if (pos < left_size) {
+        node = nodes_[node].left;
+      } else {
+        pos -= left_size + 1;
+        node = nodes_[node].right;
+      }
+    }
+  }
+
+  size_type size() const noexcept { return get_size(root_); }
+  [[nodiscard]] bool empty() const noexcept { return root_ == null; }
+
+ private:
+  size_type create_node(const value_type &value) {
+    Node node {value, value, 1, null, null, priority_type(random_engine_())};
+    if (free_.empty()) {
+      nodes_.push_back(node);
+      return nodes_.size() - 1;
+    }
+    auto id = free_.back();
+    free_.pop_back();
+    nodes_[id] = node;
+    return id;
+  }
+
+  size_type get_size(size_type node) const noexcept {
+    return node == null ? 0 : nodes_[node].size;
+  }
+
+  void update(size_type node) noexcept {
+    auto &&[value, min, size, left, right, _] = nodes_[node];
+    min  = value;
+    size = 1;
+    for (auto child : {left, right}) {
+      if (child != null) {
+        min   = std::min(min, nodes_[child].min);
+        size += nodes_[child].size;
+      }
+    }
+  }
+
+  // the first count elements go to the left tree
+  std::pair<size_type, size_type> split(size_type node, size_type count) {
+    if (node == null) { return {null, null}; }
+
+    auto left_size = get_size(nodes_[node].left);
+    if (left_size < count) {
+      auto [left, right] = split(nodes_[node].right, count - left_size - 1);
+      nodes_[node].right = left;
+      update(node);
+      return {node, right};
+    }
+    auto [left, right] = split(nodes_[node].left, count);
+    nodes_[node].left = right;
+    update(node);
+    return {left, node};
+  }
+
+  size_type merge(size_type left, size_type right) {
+    if (left == null)  { return right; }
+    if (right == null) { return left;  }
+
+    if (nodes_[left].priority > nodes_[right].priority) {
+      nodes_[left].right = merge(nodes_[left].right, right);
+      update(left);
+      return left;
+    }
+    nodes_[right].left = merge(left, nodes_[right].left);
+    update(right);
+    return right;
+  }
+
+  // l and r are positions inside the subtree of node
+  value_type range_min(size_type node, size_type l, size_type r) const {
+    auto &&[value, min, size, left, right, _] = nodes_[node];
+    if (l == 0 && r == size - 1) {
+      return min;
+    }
+    auto left_size = get_size(left);
+    if (r < left_size) {
+      return range_min(left, l, r);
+    }
+    if (l > left_size) {
+      return range_min(right, l - left_size - 1, r - left_size - 1);
+    }
+    auto answer = value;
+    if (l < left_size) {
+      answer = std::min(answer, range_min(left, l, left_size - 1));
+    }
+    if (r > left_size) {
+      answer = std::min(answer, range_min(right, 0, r - left_size - 1));
+    }
+    return answer;
+  }
+
+  void check_position(size_type pos, size_type bound) const {
+    if (pos >= bound) {
+      throw std::out_of_range {"position " + std::to_string(pos) +
+                               " is out of the sequence of size " +
+                               std::to_string(size())};
+    }
+  }
+
+ private:
+  std::vector<Node> nodes_;
+  std::vector<size_type> free_;
+  size_type root_ {null};
+  std::minstd_rand random_engine_ {std::random_device{}()};
+};
+
+template <std::input_iterator Iter>
+ImplicitTreap(Iter, Iter) ->
+                  ImplicitTreap<typename std::iterator_traits<Iter>::value_type>;
+
+} // <--- namespace yLAB
+
@@ -10,10 +10,16 @@ namespace yLAB {
 
 template <typename> class Treap;
 
+/*
+ * In-order iterator: nodes of a tree are stored sorted by key in contiguous
+ * spans, so increment and decrement are O(1) steps over the memory.
+ * Iterators are invalidated by merge and split.
+*/
+
 template<typename KeyT, typename Priority>
 class TreeIterator final {
   using node_type      = detail::Node<KeyT, Priority>;
-  using base_node      = typename node_type::base_node;
+  using span_type      = detail::Span<node_type>;
   using key_type       = typename node_type::key_type;
   using priority_type  = typename node_type::priority_type;
 
@@ -22,20 +28,25 @@ class TreeIterator final {
   using iterator_category = std::bidirectional_iterator_tag;
   using value_type        = std::pair<key_type, priority_type>;
   using reference         = std::pair<key_type&, priority_type&>;
-  using pointer           = base_node*;
-  using const_pointer     = const base_node*;
+  using pointer           = node_type*;
+  using const_pointer     = const node_type*;
   using const_reference   = std::pair<const key_type&, const priority_type&>;
   using difference_type   = std::ptrdiff_t;
 
   constexpr TreeIterator() = default;
 
   constexpr TreeIterator& operator++() {
-    ptr_ = node_type::successor(static_cast<node_type*>(ptr_));
+    if (++ptr_ == span_->last) {
+      ptr_ = (++span_ == spans_end_ ? nullptr : span_->first);
+    }
     return *this;
   }
 
   constexpr TreeIterator& operator--() {
-    ptr_ = node_type::predecessor(ptr_);
+    if (span_ == spans_end_ || ptr_ == span_->first) {
+      ptr_ = (--span_)->last;
+    }
+    --ptr_;
     return *this;
   }
 
@@ -52,22 +63,27 @@ class TreeIterator final {
   }
 
   constexpr const_reference operator*() const noexcept {
-    auto node_ptr = static_cast<node_type*>(ptr_);
-    return {node_ptr->key(), node_ptr->priority()};
+    return {ptr_->key(), ptr_->priority()};
   }
 
   constexpr ProxyPair operator->() const noexcept {
     return {this->operator*()};
   }
 
-  constexpr auto operator<=>(const TreeIterator&) const = default;
+  constexpr bool operator==(const TreeIterator &rhs) const noexcept {
+    return ptr_ == rhs.ptr_;
+  }
 
   template<typename> friend class Treap;
  private:
 /*----------------------------------------------------------------------------------*/
+  const span_type *span_ {nullptr};
+  const span_type *spans_end_ {nullptr};
   pointer ptr_ {nullptr};
 
-  constexpr TreeIterator(pointer ptr): ptr_ {ptr} {}
+  constexpr TreeIterator(const span_type *span, const span_type *spans_end)
+      : span_ {span}, spans_end_ {spans_end},
+        ptr_ {span == spans_end ? nullptr : span->first} {}
   
   struct ProxyPair final {
     const_reference *operator->() {
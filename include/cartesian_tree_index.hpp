@@ -0,0 +1,244 @@
+#pragma once
+
+#include <vector>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+
+#include "nearest_smaller.hpp"
+#include "memory_usage.hpp"
+#include "utils.hpp"
+
+namespace yLAB {
+
+/*
+ * Queries over the Cartesian tree of an array: the tree Treap(Iter, Iter)
+ * and RmqSolver build, node i is the element array[i]. Among equal values
+ * the later one is the ancestor, so the root is the last minimum.
+ *
+ * The tree is built in O(n) with the same stack. depth(), parent() and
+ * subtree() are O(1) lookups. The subtree of i is the maximal range where
+ * array[i] is the minimum: it ends before the nearest smaller value on the
+ * left and before the nearest smaller or equal one on the right.
+ *
+ * kth_ancestor() is O(1) too. A jump pointer takes it 2^j levels up, to a
+ * node whose subtree is at least 2^j levels deep, and the ladder of that
+ * node covers the rest: the tree is split into long paths, the ladder of a
+ * path of length L is the path with L more ancestors above it. Only the
+ * leaves ending the paths keep jump pointers: an ancestor of a node is the
+ * same ancestor of the leaf below it, just further up. Ladders take at most
+ * 2n, jump pointers leaves * log(height). Both are built by the first call.
+*/
+
+template <typename Allocator = std::allocator<std::size_t>>
+class CartesianTreeIndex final {
+ public:
+  using size_type      = std::size_t;
+  using allocator_type = Allocator;
+  // the first and the last position of a subtree
+  using range_type     = std::pair<size_type, size_type>;
+ private:
+  using vector_type = std::vector<size_type, allocator_type>;
+  using jumps_type  = std::vector<vector_type, typename std::allocator_traits<
+                                  allocator_type>::template rebind_alloc<vector_type>>;
+ public:
+  template <std::forward_iterator Iter>
+  CartesianTreeIndex(Iter begin, Iter end, const allocator_type &alloc = allocator_type())
+      : parents_(alloc), depths_(alloc), firsts_(alloc), lasts_(alloc),
+        jumps_(alloc), ladders_(alloc), ladder_pos_(alloc), path_of_(alloc), leaves_(alloc),
+        built_ {std::make_unique<std::once_flag>()} {
+    build(begin, end);
+  }
+
+  size_type size() const noexcept { return parents_.size(); }
+  size_type root() const noexcept { return root_; }
+
+  // the root is at depth 0
+  size_type depth(size_type node) const { return depths_[node]; }
+  // no_position for the root
+  size_type parent(size_type node) const { return parents_[node]; }
+  range_type subtree(size_type node) const { return {firsts_[node], lasts_[node]}; }
+
+  // the ancestor k levels above the node, no_position if the tree isn't that deep
+  size_type kth_ancestor(size_type node, size_type k) const {
+    if (k > depths_[node]) { return no_position; }
+    if (k == 0) { return node; }
+    std::call_once(*built_, [this] { build_ladders(); });
+    // the same ancestor of the leaf the long path of the node ends with
+    auto path  = path_of_[node];
+    k += depths_[leaves_[path]] - depths_[node];
+    auto power = log2_floor(k);
+    auto jump  = jumps_[power][path];
+    return ladders_[ladder_pos_[jump] - (k - (size_type{1} << power))];
+  }
+
+  // the ancestor at the depth, no_position if the node is above it
+  size_type level_ancestor(size_type node, size_type depth) const {
+    if (depth > depths_[node]) { return no_position; }
+    return kth_ancestor(node, depths_[node] - depth);
+  }
+
+  // ladders and jump pointers are counted once built
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("parents",  MemoryUsage::bytes(parents_));
+    usage.add("depths",   MemoryUsage::bytes(depths_));
+    usage.add("subtrees", MemoryUsage::bytes(firsts_) + MemoryUsage::bytes(lasts_));
+    usage.add("jump pointers", MemoryUsage::bytes(jumps_));
+    for (auto &&level : jumps_) {
+      usage.add("jump pointers", MemoryUsage::bytes(level));
+    }
+    usage.add("ladders", MemoryUsage::bytes(ladders_) + MemoryUsage::bytes(ladder_pos_) +
+                         MemoryUsage::bytes(path_of_) + MemoryUsage::bytes(leaves_));
+    return usage;
+  }
+
+ private:
+  template <typename Iter>
+  void build(Iter begin, Iter end) {
+    using value_type = typename std::iterator_traits<Iter>::value_type;
+
+    auto size = static_cast<size_type>(std::distance(begin, end));
+    parents_.assign(size, no_position);
+    depths_.assign(size, 0);
+    firsts_.resize(size);
+    lasts_.assign(size, size - 1);
+    if (size == 0) { return; }
+
+    // the right spine of the tree built so far, as in Treap(Iter, Iter)
+    std::vector<std::pair<size_type, value_type>> stack;
+    for (size_type id = 0; begin != end; ++begin, ++id) {
+      // the popped nodes end before id, the last one becomes its left child
+      size_type popped = no_position;
+      while (!stack.empty() && !(stack.back().second < *begin)) {
+        popped = stack.back().first;
+        lasts_[popped] = id - 1;
+        stack.pop_back();
+      }
+      if (popped != no_position) { parents_[popped] = id; }
+      firsts_[id] = popped == no_position ? id : firsts_[popped];
+      if (!stack.empty()) { parents_[id] = stack.back().first; }
+      stack.emplace_back(id, *begin);
+    }
+    root_ = stack.front().first;
+
+    for (auto node : preorder()) {
+      if (node != root_) { depths_[node] = depths_[parents_[node]] + 1; }
+    }
+  }
+
+  // the left child of a node is before it, the right one is after it
+  std::pair<std::vector<size_type>, std::vector<size_type>> children() const {
+    std::vector<size_type> left(size(), no_position), right(size(), no_position);
+    for (size_type id = 0; id < size(); ++id) {
+      auto parent = parents_[id];
+      if (parent == no_position) { continue; }
+      (id < parent ? left : right)[parent] = id;
+    }
+    return {std::move(left), std::move(right)};
+  }
+
+  // parents go before their children
+  std::vector<size_type> preorder() const {
+    std::vector<size_type> order, stack;
+    order.reserve(size());
+    if (size() == 0) { return order; }
+    auto [left, right] = children();
+    stack.push_back(root_);
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+      order.push_back(node);
+      if (right[node] != no_position) { stack.push_back(right[node]); }
+      if (left[node]  != no_position) { stack.push_back(left[node]); }
+    }
+    return order;
+  }
+
+  void build_ladders() const {
+    auto size  = this->size();
+    auto order = preorder();
+    auto [left, right] = children();
+
+    // the number of nodes on the longest path down and the child it goes through
+    std::vector<size_type> heights(size, 1), long_child(size, no_position);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      auto node = *it;
+      for (auto child : {left[node], right[node]}) {
+        if (child != no_position && heights[child] + 1 > heights[node]) {
+          heights[node]    = heights[child] + 1;
+          long_child[node] = child;
+        }
+      }
+    }
+
+    ladders_.reserve(2 * size);
+    ladder_pos_.resize(size);
+    path_of_.resize(size);
+    std::vector<size_type> above;
+    for (auto top : order) {
+      if (top != root_ && long_child[parents_[top]] == top) { continue; }
+      // the path goes down from its top, the ladder doubles it upwards
+      above.clear();
+      for (auto node = parents_[top]; node != no_position && above.size() < heights[top];
+           node = parents_[node]) {
+        above.push_back(node);
+      }
+      ladders_.insert(ladders_.end(), above.rbegin(), above.rend());
+      for (auto node = top;; node = long_child[node]) {
+        ladder_pos_[node] = ladders_.size();
+        path_of_[node]    = leaves_.size();
+        ladders_.push_back(node);
+        if (long_child[node] == no_position) {
+          leaves_.push_back(node);
+          break;
+        }
+      }
+    }
+
+    auto max_depth  = *std::max_element(depths_.begin(), depths_.end());
+    auto levels_num = max_depth ? log2_floor(max_depth) + 1 : 0;
+    // jumps_[level][path] is 2^level levels above the leaf of the path
+    jumps_.assign(levels_num, vector_type(parents_.get_allocator()));
+    for (int level = 0; level < levels_num; ++level) {
+      auto &jumps = jumps_[level];
+      jumps.resize(leaves_.size());
+      // 2^level = 2^(level - 1) + 2^(level - 1): the second half is on a ladder
+      for (size_type path = 0; path < leaves_.size(); ++path) {
+        auto leaf = leaves_[path];
+        if (depths_[leaf] < (size_type{1} << level)) {
+          jumps[path] = no_position;
+        } else if (level == 0) {
+          jumps[path] = parents_[leaf];
+        } else {
+          auto half = jumps_[level - 1][path];
+          jumps[path] = ladders_[ladder_pos_[half] - (size_type{1} << (level - 1))];
+        }
+      }
+    }
+  }
+
+ private:
+  vector_type parents_;
+  vector_type depths_;
+  vector_type firsts_;
+  vector_type lasts_;
+  size_type root_ = no_position;
+
+  mutable jumps_type  jumps_;
+  mutable vector_type ladders_;
+  // the position of a node in the ladder of its long path
+  mutable vector_type ladder_pos_;
+  // the long path of a node and the leaf every path ends with
+  mutable vector_type path_of_;
+  mutable vector_type leaves_;
+  std::unique_ptr<std::once_flag> built_;
+};
+
+template <std::forward_iterator Iter>
+CartesianTreeIndex(Iter, Iter) -> CartesianTreeIndex<>;
+
+} // <--- namespace yLAB
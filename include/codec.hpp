@@ -0,0 +1,351 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <string>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+
+#include "range_queries.hpp"
+
+namespace yLAB {
+
+/*
+ * Compact binary format of the input and of the answers. Integers are cut
+ * into blocks of 128; a block keeps the zigzag codes of the values (or of the
+ * deltas between neighbours, for sorted-like columns) as frame of reference:
+ * varint of the minimum code, a byte with the width of the biggest offset
+ * from it and the offsets bit-packed in that width. The offsets are spread
+ * over 8 interleaved 64-bit lanes (value i goes to lane i % 8), so every lane
+ * is unpacked with the same shifts and the loops over lanes vectorize.
+ *
+ *   input   - magic, varint n, blocks of the array (deltas),
+ *             varint q, for every 128 queries a block of the left borders
+ *             (deltas) and a block of r - l;
+ *   answers - magic, for every 128 answers varint count and a block,
+ *             varint 0 at the end.
+ * Words are in the byte order of the host.
+*/
+
+namespace codec {
+
+  using size_type = std::size_t;
+  using word_type = std::uint64_t;
+
+  inline constexpr size_type block_size = 128;
+  inline constexpr size_type lanes      = 8;
+  inline constexpr size_type lane_size  = block_size / lanes;
+  inline constexpr std::array<char, 4> magic {'R', 'M', 'Q', '1'};
+
+  constexpr word_type zigzag(std::int64_t value) noexcept {
+    return (static_cast<word_type>(value) << 1) ^ static_cast<word_type>(value >> 63);
+  }
+
+  constexpr std::int64_t unzigzag(word_type code) noexcept {
+    return static_cast<std::int64_t>(code >> 1) ^ -static_cast<std::int64_t>(code & 1);
+  }
+
+  // words of one lane for the offsets of width bits
+  constexpr size_type lane_words(unsigned width) noexcept {
+    return (lane_size * width + 63) / 64;
+  }
+
+  constexpr size_type packed_words(unsigned width) noexcept {
+    return lanes * lane_words(width);
+  }
+
+  // values[0 .. block_size) of at most width bits to packed_words(width) words
+  inline void pack(const word_type *values, unsigned width, word_type *words) {
+    std::fill(words, words + packed_words(width), 0);
+    if (width == 0) { return ; }
+    for (size_type pos = 0; pos < lane_size; ++pos) {
+      auto bit = pos * width, shift = bit % 64;
+      auto low = words + bit / 64 * lanes;
+      for (size_type lane = 0; lane < lanes; ++lane) {
+        low[lane] |= values[pos * lanes + lane] << shift;
+      }
+      if (shift + width > 64) {
+        for (size_type lane = 0; lane < lanes; ++lane) {
+          low[lanes + lane] |= values[pos * lanes + lane] >> (64 - shift);
+        }
+      }
+    }
+  }
+
+  inline void unpack(const word_type *words, unsigned width, word_type *values) {
+    if (width == 0) {
+      std::fill(values, values + block_size, 0);
+      return ;
+    }
+    auto mask = (width == 64 ? ~word_type{0} : (word_type{1} << width) - 1);
+    for (size_type pos = 0; pos < lane_size; ++pos) {
+      auto bit = pos * width, shift = bit % 64;
+      auto low = words + bit / 64 * lanes;
+      auto out = values + pos * lanes;
+      if (shift + width > 64) {
+        for (size_type lane = 0; lane < lanes; ++lane) {
+          out[lane] = ((low[lane] >> shift) | (low[lanes + lane] << (64 - shift))) & mask;
+        }
+      } else {
+        for (size_type lane = 0; lane < lanes; ++lane) {
+          out[lane] = (low[lane] >> shift) & mask;
+        }
+      }
+    }
+  }
+
+  class Writer final {
+   public:
+    static constexpr size_type buffer_size = 1 << 20;
+
+    explicit Writer(std::ostream &os) : os_ {os} {
+      buffer_.reserve(buffer_size);
+      buffer_.append(magic.begin(), magic.end());
+    }
+
+    Writer(const Writer&) = delete;
+    Writer &operator=(const Writer&) = delete;
+
+    ~Writer() { flush(); }
+
+    void varint(word_type value) {
+      for (; value >= 0x80; value >>= 7) {
+        buffer_.push_back(static_cast<char>(value | 0x80));
+      }
+      buffer_.push_back(static_cast<char>(value));
+    }
+
+    // Up to block_size values. With prev the block keeps the deltas from
+    // *prev and the previous values of the block, *prev becomes the last value.
+    void block(const std::int64_t *values, size_type count, std::int64_t *prev = nullptr) {
+      std::array<word_type, block_size> codes {};
+      for (size_type id = 0; id < count; ++id) {
+        codes[id] = zigzag(prev ? static_cast<std::int64_t>(
+                                    static_cast<word_type>(values[id]) -
+                                    static_cast<word_type>(id ? values[id - 1] : *prev))
+                                : values[id]);
+      }
+      if (prev && count) { *prev = values[count - 1]; }
+
+      auto base = (count ? *std::min_element(codes.begin(), codes.begin() + count) : 0);
+      word_type max_offset = 0;
+      for (size_type id = 0; id < count; ++id) {
+        codes[id] -= base;
+        max_offset = std::max(max_offset, codes[id]);
+      }
+      std::fill(codes.begin() + count, codes.end(), 0);
+      auto width = static_cast<unsigned>(std::bit_width(max_offset));
+      varint(base);
+      buffer_.push_back(static_cast<char>(width));
+
+      std::array<word_type, packed_words(64)> words;
+      pack(codes.data(), width, words.data());
+      auto bytes = packed_words(width) * sizeof(word_type);
+      buffer_.append(reinterpret_cast<const char*>(words.data()), bytes);
+      if (buffer_.size() >= buffer_size) { flush(); }
+    }
+
+    void flush() {
+      os_.write(buffer_.data(), buffer_.size());
+      buffer_.clear();
+    }
+
+   private:
+    std::ostream &os_;
+    std::string buffer_;
+  };
+
+  class Reader final {
+   public:
+    static constexpr size_type buffer_size = 1 << 20;
+
+    explicit Reader(std::istream &is) : is_ {is}, buffer_(buffer_size) {
+      std::array<char, magic.size()> header;
+      read(header.data(), header.size());
+      if (header != magic) {
+        throw std::runtime_error {"the input is not in the binary format"};
+      }
+    }
+
+    Reader(const Reader&) = delete;
+    Reader &operator=(const Reader&) = delete;
+
+    word_type varint() {
+      word_type value = 0;
+      for (unsigned shift = 0; shift < 64; shift += 7) {
+        auto byte = static_cast<unsigned char>(get());
+        value |= static_cast<word_type>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) { return value; }
+      }
+      throw std::runtime_error {"invalid varint in the binary input"};
+    }
+
+    // the block of count values written by Writer::block with the same prev
+    void block(std::int64_t *values, size_type count, std::int64_t *prev = nullptr) {
+      auto base  = varint();
+      auto width = static_cast<unsigned>(static_cast<unsigned char>(get()));
+      if (width > 64) {
+        throw std::runtime_error {"invalid block width " + std::to_string(width)};
+      }
+      std::array<word_type, packed_words(64)> words;
+      read(reinterpret_cast<char*>(words.data()), packed_words(width) * sizeof(word_type));
+      std::array<word_type, block_size> codes;
+      unpack(words.data(), width, codes.data());
+
+      count = std::min(count, block_size);
+      if (!prev) {
+        for (size_type id = 0; id < count; ++id) {
+          values[id] = unzigzag(codes[id] + base);
+        }
+        return;
+      }
+      auto value = static_cast<word_type>(*prev);
+      for (size_type id = 0; id < count; ++id) {
+        value += static_cast<word_type>(unzigzag(codes[id] + base));
+        values[id] = static_cast<std::int64_t>(value);
+      }
+      if (count) { *prev = values[count - 1]; }
+    }
+
+   private:
+    char get() {
+      if (pos_ == end_ && !refill()) {
+        throw std::runtime_error {"unexpected end of the binary input"};
+      }
+      return *pos_++;
+    }
+
+    void read(char *data, size_type size) {
+      while (size) {
+        if (pos_ == end_ && !refill()) {
+          throw std::runtime_error {"unexpected end of the binary input"};
+        }
+        auto part = std::min<size_type>(size, end_ - pos_);
+        std::memcpy(data, pos_, part);
+        data += part, pos_ += part, size -= part;
+      }
+    }
+
+    bool refill() {
+      is_.read(buffer_.data(), buffer_.size());
+      pos_ = buffer_.data();
+      end_ = pos_ + is_.gcount();
+      return pos_ != end_;
+    }
+
+   private:
+    std::istream &is_;
+    std::vector<char> buffer_;
+    const char *pos_ {nullptr};
+    const char *end_ {nullptr};
+  };
+
+  // reads count values written block by block with deltas, one by one
+  class ValueReader final {
+   public:
+    ValueReader(Reader &reader, size_type count) : reader_ {reader}, left_ {count} {}
+
+    // false after count values
+    bool read(std::int64_t &value) {
+      if (pos_ == block_size) {
+        if (!left_) { return false; }
+        auto count = std::min(left_, block_size);
+        reader_.block(block_.data(), count, &prev_);
+        left_ -= count, pos_ = 0;
+      }
+      value = block_[pos_++];
+      return true;
+    }
+
+   private:
+    Reader &reader_;
+    size_type left_;
+    size_type pos_ {block_size};
+    std::int64_t prev_ {0};
+    std::array<std::int64_t, block_size> block_;
+  };
+
+  // Reads the queries section block by block: varint q is read on the first
+  // call, every call appends up to max_queries queries (a multiple of
+  // block_size) to the chunk.
+  class QueryReader final {
+   public:
+    explicit QueryReader(Reader &reader) : reader_ {reader} {}
+
+    void read(std::vector<range_query_type> &chunk, size_type max_queries) {
+      if (!started_) {
+        left_ = reader_.varint();
+        started_ = true;
+      }
+      std::array<std::int64_t, block_size> lefts, lengths;
+      for (size_type read = 0; left_ && read < max_queries; read += block_size) {
+        auto count = std::min(left_, block_size);
+        reader_.block(lefts.data(), count, &prev_left_);
+        reader_.block(lengths.data(), count);
+        for (size_type id = 0; id < count; ++id) {
+          auto left = static_cast<size_type>(lefts[id]);
+          chunk.emplace_back(left, left + static_cast<size_type>(lengths[id]));
+        }
+        left_ -= count;
+      }
+    }
+
+   private:
+    Reader &reader_;
+    size_type left_ {0};
+    std::int64_t prev_left_ {0};
+    bool started_ {false};
+  };
+
+  // writes the queries section, the counterpart of QueryReader
+  inline void write_queries(Writer &writer, const std::vector<range_query_type> &queries,
+                            std::int64_t &prev_left) {
+    std::array<std::int64_t, block_size> lefts, lengths;
+    for (size_type first = 0; first < queries.size(); first += block_size) {
+      auto count = std::min(block_size, queries.size() - first);
+      for (size_type id = 0; id < count; ++id) {
+        auto [l, r] = queries[first + id];
+        lefts[id]   = static_cast<std::int64_t>(l);
+        lengths[id] = static_cast<std::int64_t>(r - l);
+      }
+      writer.block(lefts.data(), count, &prev_left);
+      writer.block(lengths.data(), count);
+    }
+  }
+
+  // the answers section: count and block for every block_size answers
+  template <typename T>
+  void write_answers(Writer &writer, const std::vector<T> &answers) {
+    std::array<std::int64_t, block_size> values;
+    for (size_type first = 0; first < answers.size(); first += block_size) {
+      auto count = std::min(block_size, answers.size() - first);
+      std::copy_n(answers.begin() + first, count, values.begin());
+      writer.varint(count);
+      writer.block(values.data(), count);
+    }
+  }
+
+  inline void end_answers(Writer &writer) { writer.varint(0); }
+
+  inline std::vector<std::int64_t> read_answers(Reader &reader) {
+    std::vector<std::int64_t> answers;
+    for (auto count = reader.varint(); count; count = reader.varint()) {
+      if (count > block_size) {
+        throw std::runtime_error {"invalid block size " + std::to_string(count)};
+      }
+      answers.resize(answers.size() + count);
+      reader.block(answers.data() + answers.size() - count, count);
+    }
+    return answers;
+  }
+
+} // <--- namespace codec
+
+} // <--- namespace yLAB
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <initializer_list>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <bit>
+
+#include "memory_usage.hpp"
+
+namespace yLAB {
+
+/*
+ * Range queries for any associative operation, not only for idempotent ones
+ * like min: range sums, xors, products of matrices and so on. On level k the
+ * array is cut into blocks of 2^(k + 1) elements, and for each block the
+ * table keeps the folds from every element to the middle of the block. Any
+ * query [l, r] with l != r crosses the middle of exactly one such block (the
+ * level is the highest differing bit of l and r), so it's answered with one
+ * combine of two precomputed folds.
+ *
+ * All levels live in one flat array, the first row is the array itself.
+*/
+
+template <typename T, typename Operation = std::plus<T>,
+          typename Allocator = std::allocator<T>>
+class DisjointSparseTable final {
+ public:
+  using size_type      = std::size_t;
+  using value_type     = T;
+  using operation_type = Operation;
+  using allocator_type = Allocator;
+  using table_type     = std::vector<value_type, allocator_type>;
+
+  DisjointSparseTable() = default;
+
+  DisjointSparseTable(std::initializer_list<value_type> i_list,
+                      const operation_type &op = operation_type(),
+                      const allocator_type &alloc = allocator_type())
+      : DisjointSparseTable(i_list.begin(), i_list.end(), op, alloc) {}
+
+  // Complexity O(n log n)
+  template <std::input_iterator Iter>
+  DisjointSparseTable(Iter begin, Iter end,
+                      const operation_type &op = operation_type(),
+                      const allocator_type &alloc = allocator_type())
+      : table_(alloc), op_ {op} {
+    table_.assign(begin, end);
+    size_ = table_.size();
+    if (size_ == 0) { return ; }
+
+    table_.resize(levels_number(size_) * size_, table_.front());
+    for (size_type level = 1; level < levels_number(size_); ++level) {
+      auto row  = table_.begin() + level * size_;
+      auto half = size_type{1} << (level - 1);
+      for (size_type middle = half; middle < size_; middle += 2 * half) {
+        // folds from the left half to the middle
+        row[middle - 1] = table_[middle - 1];
+        for (auto id = middle - 1; id > middle - half; --id) {
+          row[id - 1] = op_(table_[id - 1], row[id]);
+        }
+        // folds from the middle to the right half
+        row[middle] = table_[middle];
+        for (auto id = middle + 1, end = std::min(size_, middle + half); id < end; ++id) {
+          row[id] = op_(row[id - 1], table_[id]);
+        }
+      }
+    }
+  }
+
+  // fold of [query.first, query.second], borders may come in any order
+  value_type ans_query(std::pair<size_type, size_type> query) const {
+    auto [l, r] = query;
+    if (l > r) {
+      std::swap(l, r);
+    }
+    if (l == r) {
+      return table_[l];
+    }
+    auto row = std::bit_width(l ^ r) * size_;
+    return op_(table_[row + l], table_[row + r]);
+  }
+
+  size_type size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("disjoint sparse table", MemoryUsage::bytes(table_));
+    return usage;
+  }
+
+  // memory_usage() of the table of n elements
+  static MemoryUsage estimate_memory(size_type n) {
+    MemoryUsage usage;
+    usage.add("disjoint sparse table", levels_number(n) * n * sizeof(value_type));
+    return usage;
+  }
+
+ private:
+  // the array itself and a level for each bit of the indexes
+  static size_type levels_number(size_type n) noexcept {
+    return n > 1 ? std::bit_width(n - 1) + 1 : n;
+  }
+
+ private:
+  table_type table_;
+  size_type size_ {0};
+  [[no_unique_address]] operation_type op_;
+};
+
+template <std::input_iterator Iter>
+DisjointSparseTable(Iter, Iter) ->
+           DisjointSparseTable<typename std::iterator_traits<Iter>::value_type>;
+
+template <std::input_iterator Iter, typename Operation>
+DisjointSparseTable(Iter, Iter, Operation) ->
+           DisjointSparseTable<typename std::iterator_traits<Iter>::value_type,
+                               Operation>;
+
+} // <--- namespace yLAB
+
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <new>
+#include <limits>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace yLAB {
+
+enum class Pages {
+  usual,       // plain operator new
+  transparent, // transparent huge pages requested with madvise
+  hugetlb      // explicit huge pages, falls back to transparent ones
+};
+
+enum class NumaPolicy {
+  local,      // kernel default: pages are placed on the node touching them first
+  interleave  // pages are spread round-robin across all allowed nodes
+};
+
+/*
+ * Allocator for the large arrays of RmqSolver and SparseTable. Allocations
+ * smaller than a huge page are served by operator new, bigger ones are mapped
+ * with mmap at a huge page boundary, so that random queries over gigabytes of
+ * tables don't thrash the TLB. All the requests to the kernel are advisory:
+ * if they fail, the memory is still usable with usual pages.
+ *
+ * The tables are not replicated per NUMA node, although the pipeline, the
+ * server and the batch engine answer queries from many threads. Their
+ * threads aren't pinned to nodes, so none of them knows which copy is
+ * local, and every copy would count against --memory-limit. Interleaving
+ * spreads the remote accesses evenly over the nodes instead.
+*/
+
+template <typename T>
+class HugePageAllocator {
+ public:
+  using value_type      = T;
+  using size_type       = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  static constexpr size_type huge_page_size = 2 * 1024 * 1024;
+
+  constexpr HugePageAllocator(Pages pages = Pages::transparent,
+                              NumaPolicy numa = NumaPolicy::local) noexcept
+      : pages_ {pages}, numa_ {numa} {}
+
+  template <typename U>
+  constexpr HugePageAllocator(const HugePageAllocator<U> &rhs) noexcept
+      : pages_ {rhs.pages()}, numa_ {rhs.numa()} {}
+
+  T *allocate(size_type n) {
+    if (n > std::numeric_limits<size_type>::max() / sizeof(T)) {
+      throw std::bad_array_new_length {};
+    }
+    if (!is_mapped(n)) {
+      return static_cast<T*>(::operator new(n * sizeof(T),
+                                            std::align_val_t {alignof(T)}));
+    }
+    auto length = mapping_length(n);
+    void *ptr   = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (pages_ == Pages::hugetlb) {
+      ptr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (ptr == MAP_FAILED) {
+      ptr = map_aligned(length);
+#ifdef MADV_HUGEPAGE
+      ::madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+    }
+    if (numa_ == NumaPolicy::interleave) {
+      interleave(ptr, length);
+    }
+    return static_cast<T*>(ptr);
+  }
+
+  void deallocate(T *ptr, size_type n) noexcept {
+    if (!is_mapped(n)) {
+      ::operator delete(ptr, std::align_val_t {alignof(T)});
+      return ;
+    }
+    ::munmap(ptr, mapping_length(n));
+  }
+
+  constexpr Pages pages() const noexcept { return pages_; }
+  constexpr NumaPolicy numa() const noexcept { return numa_; }
+
+  template <typename U>
+  constexpr bool operator==(const HugePageAllocator<U> &rhs) const noexcept {
+    return pages_ == rhs.pages() && numa_ == rhs.numa();
+  }
+
+ private:
+  constexpr bool is_mapped(size_type n) const noexcept {
+    return pages_ != Pages::usual && n * sizeof(T) >= huge_page_size;
+  }
+
+  static constexpr size_type mapping_length(size_type n) noexcept {
+    return (n * sizeof(T) + huge_page_size - 1) / huge_page_size * huge_page_size;
+  }
+
+  // the kernel can back a region with huge pages only in aligned 2MB pieces
+  static void *map_aligned(size_type length) {
+    auto raw = ::mmap(nullptr, length + huge_page_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+      throw std::bad_alloc {};
+    }
+    auto begin   = reinterpret_cast<std::uintptr_t>(raw);
+    auto aligned = (begin + huge_page_size - 1) / huge_page_size * huge_page_size;
+    if (auto head = aligned - begin; head) {
+      ::munmap(raw, head);
+    }
+    if (auto tail = begin + huge_page_size - aligned; tail) {
+      ::munmap(reinterpret_cast<void*>(aligned + length), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  static void interleave([[maybe_unused]] void *ptr,
+                         [[maybe_unused]] size_type length) noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+    // MPOL_INTERLEAVE from <numaif.h>, the kernel restricts the mask to
+    // the nodes allowed for the process
+    constexpr int mpol_interleave = 3;
+    unsigned long nodes_mask = ~0ul;
+    ::syscall(SYS_mbind, ptr, length, mpol_interleave, &nodes_mask,
+              sizeof(nodes_mask) * CHAR_BIT, 0);
+#endif
+  }
+
+ private:
+  Pages pages_;
+  NumaPolicy numa_;
+};
+
+} // <--- namespace yLAB
+
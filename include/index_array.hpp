@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "memory_usage.hpp"
+
+namespace yLAB {
+
+/*
+ * Array of indexes which are known to be at most max_index before it's
+ * filled. While max_index fits into 32 bits the indexes are kept in 32 bits,
+ * so for any array below 2^32 elements the array takes half of the memory of
+ * size_type ones; otherwise they are size_type. The width is chosen once, by
+ * reserve() or resize().
+*/
+
+template <typename Allocator = std::allocator<std::size_t>>
+class IndexArray final {
+ public:
+  using size_type      = std::size_t;
+  using allocator_type = Allocator;
+ private:
+  using narrow_type = std::uint32_t;
+
+  template <typename U>
+  using vector_type = std::vector<U, typename std::allocator_traits<
+                                     allocator_type>::template rebind_alloc<U>>;
+ public:
+  static constexpr size_type max_narrow = std::numeric_limits<narrow_type>::max();
+
+  explicit IndexArray(const allocator_type &alloc = allocator_type())
+      : narrow_(alloc), wide_(alloc) {}
+
+  // bytes taken by an index not greater than max_index
+  static constexpr size_type index_size(size_type max_index) noexcept {
+    return max_index > max_narrow ? sizeof(size_type) : sizeof(narrow_type);
+  }
+
+  void reserve(size_type count, size_type max_index) {
+    wide_index_ = max_index > max_narrow;
+    wide_index_ ? wide_.reserve(count) : narrow_.reserve(count);
+  }
+
+  void resize(size_type count, size_type max_index) {
+    wide_index_ = max_index > max_narrow;
+    wide_index_ ? wide_.resize(count) : narrow_.resize(count);
+  }
+
+  void push_back(size_type index) {
+    if (wide_index_) {
+      wide_.push_back(index);
+    } else {
+      narrow_.push_back(static_cast<narrow_type>(index));
+    }
+  }
+
+  void set(size_type pos, size_type index) noexcept {
+    if (wide_index_) {
+      wide_[pos] = index;
+    } else {
+      narrow_[pos] = static_cast<narrow_type>(index);
+    }
+  }
+
+  size_type operator[](size_type pos) const noexcept {
+    return wide_index_ ? wide_[pos] : narrow_[pos];
+  }
+
+  size_type size() const noexcept {
+    return wide_index_ ? wide_.size() : narrow_.size();
+  }
+
+  size_type bytes() const noexcept {
+    return MemoryUsage::bytes(narrow_) + MemoryUsage::bytes(wide_);
+  }
+
+ private:
+  vector_type<narrow_type> narrow_;
+  vector_type<size_type> wide_;
+  bool wide_index_ {false};
+};
+
+} // <--- namespace yLAB
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <utility>
+#include <ostream>
+#include <algorithm>
+#include <cstddef>
+
+namespace yLAB {
+
+/*
+ * Bytes taken by the named parts of a structure. The same breakdown is
+ * reported by the built structures and estimated before the construction.
+*/
+
+class MemoryUsage final {
+ public:
+  using size_type = std::size_t;
+  using part_type = std::pair<std::string_view, size_type>;
+
+  // bytes of the same part are summed up
+  void add(std::string_view name, size_type bytes) {
+    auto part = std::find_if(parts_.begin(), parts_.end(),
+                             [name](auto &&part) { return part.first == name; });
+    if (part == parts_.end()) {
+      parts_.emplace_back(name, bytes);
+    } else {
+      part->second += bytes;
+    }
+  }
+
+  void add(const MemoryUsage &rhs) {
+    for (auto &&[name, bytes] : rhs.parts_) {
+      add(name, bytes);
+    }
+  }
+
+  // 0 if there is no such part
+  size_type operator[](std::string_view name) const noexcept {
+    auto part = std::find_if(parts_.begin(), parts_.end(),
+                             [name](auto &&part) { return part.first == name; });
+    return part == parts_.end() ? 0 : part->second;
+  }
+
+  size_type total() const noexcept {
+    size_type total = 0;
+    for (auto &&part : parts_) {
+      total += part.second;
+    }
+    return total;
+  }
+
+  const std::vector<part_type> &parts() const noexcept { return parts_; }
+
+  // heap memory of a vector
+  template <typename Vector>
+  static size_type bytes(const Vector &vector) noexcept {
+    return vector.capacity() * sizeof(typename Vector::value_type);
+  }
+
+ private:
+  std::vector<part_type> parts_;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const MemoryUsage &usage) {
+  for (auto &&[name, bytes] : usage.parts()) {
+    os << name << ": " << bytes << " bytes\n";
+  }
+  return os << "total: " << usage.total() << " bytes\n";
+}
+
+} // <--- namespace yLAB
+
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+
+#include "range_queries.hpp"
+#include "parallel.hpp"
+
+namespace yLAB {
+
+/*
+ * Nearest smaller values. next_smaller(array)[i] is the first position
+ * after i with a value less than array[i], prev_smaller(array)[i] is the
+ * last one before i, no_position if there is none. It's the relation the
+ * stack of Treap(Iter, Iter) goes through.
+ *
+ * Both are built in parallel in O(n): every chunk runs the stack on its own,
+ * which resolves all the elements but the minimums of the chunk suffixes.
+ * The answer to such an element is the first smaller prefix minimum of the
+ * first chunk with a smaller minimum, both are found by binary search.
+ *
+ * next_less()/prev_less() answer "the first position after (before) pos
+ * with a value less than x" with O(log d) queries to any range minimum
+ * engine, where d is the distance to the answer.
+*/
+
+inline constexpr std::size_t no_position = std::numeric_limits<std::size_t>::max();
+
+namespace detail {
+
+  // next_smaller() for Forward, prev_smaller() on the reversed array otherwise
+  template <bool Forward, typename T>
+  std::vector<std::size_t> nearest_smaller(const std::vector<T> &array,
+                                           std::size_t threads_num) {
+    using size_type = std::size_t;
+    constexpr size_type min_chunk_size = 1 << 14;
+
+    auto size = array.size();
+    std::vector<size_type> nearest(size, no_position);
+    if (size == 0) { return nearest; }
+    // ids go along the direction, at(id) is the position in the array
+    auto at    = [size](size_type id) { return Forward ? id : size - 1 - id; };
+    auto value = [&](size_type id) -> const T& { return array[at(id)]; };
+
+    auto max_chunks = std::max<size_type>(1, std::min(4 * threads_num, size / min_chunk_size));
+    auto chunk_size = (size + max_chunks - 1) / max_chunks;
+    auto chunks_num = (size + chunk_size - 1) / chunk_size;
+    // strictly decreasing prefix minimums of every chunk and its unresolved elements
+    std::vector<std::vector<size_type>> prefix_mins(chunks_num), unresolved(chunks_num);
+    parallel_for(chunks_num, threads_num, [&](size_type, size_type chunk) {
+      auto first = chunk * chunk_size, last = std::min(size, first + chunk_size);
+      std::vector<size_type> stack;
+      for (auto id = last; id-- > first;) {
+        while (!stack.empty() && !(value(stack.back()) < value(id))) {
+          stack.pop_back();
+        }
+        if (stack.empty()) {
+          unresolved[chunk].push_back(id);
+        } else {
+          nearest[at(id)] = at(stack.back());
+        }
+        stack.push_back(id);
+      }
+      auto &mins = prefix_mins[chunk];
+      for (auto id = first; id < last; ++id) {
+        if (mins.empty() || value(id) < value(mins.back())) {
+          mins.push_back(id);
+        }
+      }
+    });
+
+    auto chunk_min = [&](size_type chunk) -> const T& { return value(prefix_mins[chunk].back()); };
+    parallel_for(chunks_num, threads_num, [&](size_type, size_type chunk) {
+      // the next chunks with minimums less than those of the chunks before them
+      std::vector<size_type> chain;
+      for (auto next = chunk + 1; next < chunks_num; ++next) {
+        if (chain.empty() || chunk_min(next) < chunk_min(chain.back())) {
+          chain.push_back(next);
+        }
+      }
+      for (auto id : unresolved[chunk]) {
+        auto &&x = value(id);
+        auto found = std::partition_point(chain.begin(), chain.end(),
+                                          [&](size_type next) { return !(chunk_min(next) < x); });
+        if (found == chain.end()) { continue; }
+        auto &mins = prefix_mins[*found];
+        auto smaller = std::partition_point(mins.begin(), mins.end(),
+                                            [&](size_type min) { return !(value(min) < x); });
+        nearest[at(id)] = at(*smaller);
+      }
+    });
+    return nearest;
+  }
+
+} // <--- namespace detail
+
+template <typename T>
+std::vector<std::size_t> next_smaller(const std::vector<T> &array,
+                                      std::size_t threads_num = default_threads_number()) {
+  return detail::nearest_smaller<true>(array, threads_num);
+}
+
+template <typename T>
+std::vector<std::size_t> prev_smaller(const std::vector<T> &array,
+                                      std::size_t threads_num = default_threads_number()) {
+  return detail::nearest_smaller<false>(array, threads_num);
+}
+
+// The first position after pos with a value less than x in the array of
+// size elements the engine is built over, no_position if there is none.
+// The range doubles until its minimum is less than x, then the answer is
+// found by binary search in the last doubling.
+template <typename Engine, typename T>
+requires RangeQueryEngine<Engine>
+std::size_t next_less(const Engine &engine, std::size_t size, std::size_t pos, const T &x) {
+  using size_type = std::size_t;
+
+  if (pos + 1 >= size) { return no_position; }
+  size_type checked = pos;
+  for (size_type length = 1;; length *= 2) {
+    auto right = std::min(size - 1, pos + length);
+    if (engine.ans_query({pos + 1, right}) < x) {
+      // the answer is in (checked, right]
+      auto left = checked + 1;
+      while (left < right) {
+        auto middle = left + (right - left) / 2;
+        if (engine.ans_query({pos + 1, middle}) < x) {
+          right = middle;
+        } else {
+          left = middle + 1;
+        }
+      }
+      return right;
+    }
+    if (right == size - 1) { return no_position; }
+    checked = right;
+  }
+}
+
+// the last position before pos with a value less than x, no_position if there is none
+template <typename Engine, typename T>
+requires RangeQueryEngine<Engine>
+std::size_t prev_less(const Engine &engine, std::size_t pos, const T &x) {
+  using size_type = std::size_t;
+
+  if (pos == 0) { return no_position; }
+  size_type checked = pos;
+  for (size_type length = 1;; length *= 2) {
+    auto left = pos - std::min(pos, length);
+    if (engine.ans_query({left, pos - 1}) < x) {
+      // the answer is in [left, checked)
+      auto right = checked - 1;
+      while (left < right) {
+        auto middle = right - (right - left) / 2;
+        if (engine.ans_query({middle, pos - 1}) < x) {
+          left = middle;
+        } else {
+          right = middle - 1;
+        }
+      }
+      return left;
+    }
+    if (left == 0) { return no_position; }
+    checked = left;
+  }
+}
+
+} // <--- namespace yLAB
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <istream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <charconv>
+#include <cstring>
+#include <concepts>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+
+namespace yLAB {
+
+// Reads whitespace separated integers through a fixed buffer, so files
+// are streamed instead of being loaded.
+class NumberReader final {
+ public:
+  using size_type = std::size_t;
+
+  static constexpr size_type buffer_size = 1 << 20;
+
+  explicit NumberReader(std::istream &is)
+      : is_ {&is}, buffer_(buffer_size) {}
+
+  explicit NumberReader(const std::string &file_name)
+      : file_ {file_name, std::ios::binary}, is_ {&file_}, buffer_(buffer_size) {
+    if (!file_) {
+      throw std::runtime_error {"can't open " + file_name};
+    }
+  }
+
+  NumberReader(const NumberReader&) = delete;
+  NumberReader &operator=(const NumberReader&) = delete;
+
+  // false if the input is over
+  template <std::integral T>
+  bool read(T &number) {
+    while (true) {
+      pos_ = std::find_if_not(pos_, end_, is_space);
+      if (pos_ != end_) { break; }
+      if (!refill()) { return false; }
+    }
+    auto token_end = std::find_if(pos_, end_, is_space);
+    // the number may be cut by the end of the buffer, refill() moves it
+    // to the front even at the end of the input
+    if (token_end == end_) {
+      refill();
+      token_end = std::find_if(pos_, end_, is_space);
+    }
+    auto [ptr, error] = std::from_chars(pos_, token_end, number);
+    if (error != std::errc{} || ptr != token_end) {
+      throw std::runtime_error {"invalid number " + std::string(pos_, token_end)};
+    }
+    pos_ = token_end;
+    return true;
+  }
+
+  template <std::integral T>
+  T read() {
+    T number;
+    if (!read(number)) {
+      throw std::runtime_error {"unexpected end of the input"};
+    }
+    return number;
+  }
+
+ private:
+  static bool is_space(char symbol) noexcept {
+    return symbol == ' ' || symbol == '\n' || symbol == '\t' || symbol == '\r';
+  }
+
+  // moves the unread tail to the front and reads after it, the tail may
+  // overlap the front
+  bool refill() {
+    auto tail_size = static_cast<size_type>(end_ - pos_);
+    if (tail_size) {
+      std::memmove(buffer_.data(), pos_, tail_size);
+    }
+    auto tail = buffer_.data() + tail_size;
+    is_->read(tail, buffer_.data() + buffer_.size() - tail);
+    auto read_size = is_->gcount();
+    pos_ = buffer_.data();
+    end_ = tail + read_size;
+    return read_size != 0;
+  }
+
+ private:
+  std::ifstream file_;
+  std::istream *is_;
+  std::vector<char> buffer_;
+  const char *pos_ {nullptr};
+  const char *end_ {nullptr};
+};
+
+} // <--- namespace yLAB
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+namespace yLAB {
+
+  inline std::size_t default_threads_number() noexcept {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // Calls func(worker_id, index) for every index in [0, count) on threads_num
+  // threads. Indexes are handed out one by one, so uneven tasks are balanced.
+  // The first exception thrown by func is rethrown in the calling thread.
+  template <typename Func>
+  void parallel_for(std::size_t count, std::size_t threads_num, Func func) {
+    threads_num = std::clamp<std::size_t>(threads_num, 1, std::max(count, 1ul));
+
+    std::atomic<std::size_t> next {0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&](std::size_t worker_id) {
+      try {
+        for (auto id = next++; id < count; id = next++) {
+          func(worker_id, id);
+        }
+      } catch (...) {
+        std::lock_guard lock {error_mutex};
+        if (!error) { error = std::current_exception(); }
+        next = count;
+      }
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(threads_num - 1);
+    for (std::size_t id = 1; id < threads_num; ++id) {
+      workers.emplace_back(worker, id);
+    }
+    worker(0);
+    workers.clear();
+
+    if (error) { std::rethrow_exception(error); }
+  }
+
+} // <--- namespace yLAB
+
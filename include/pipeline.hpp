@@ -0,0 +1,249 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <ostream>
+#include <charconv>
+#include <exception>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cstddef>
+
+#include "number_reader.hpp"
+#include "codec.hpp"
+#include "query_scheduler.hpp"
+#include "range_queries.hpp"
+#include "parallel.hpp"
+
+namespace yLAB {
+
+// Queue between two threads: push() blocks while the queue is full, so a
+// fast producer can't run far ahead of the consumer.
+template <typename T>
+class BoundedQueue final {
+ public:
+  using size_type  = std::size_t;
+  using value_type = T;
+
+  explicit BoundedQueue(size_type capacity) : capacity_ {std::max<size_type>(capacity, 1)} {}
+
+  // false if the queue is closed, the value is dropped then
+  bool push(value_type value) {
+    std::unique_lock lock {mutex_};
+    not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+    if (closed_) { return false; }
+    queue_.push_back(std::move(value));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // nullopt if the queue is closed and empty
+  std::optional<value_type> pop() {
+    std::unique_lock lock {mutex_};
+    not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+    if (queue_.empty()) { return std::nullopt; }
+    auto value = std::move(queue_.front());
+    queue_.pop_front();
+    not_full_.notify_one();
+    return value;
+  }
+
+  // the values in the queue can still be popped
+  void close() {
+    std::lock_guard lock {mutex_};
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  size_type capacity_;
+  std::deque<value_type> queue_;
+  bool closed_ {false};
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+enum class DataFormat { text, binary };
+
+/*
+ * Answers the queries of the source to the stream in three stages connected
+ * with bounded queues of chunks:
+ *  - the reader thread takes chunks of queries from the source. It starts
+ *    in the constructor, so the queries are read while the engine is being
+ *    built;
+ *  - answer() answers every chunk with ans_queries in the calling thread,
+ *    in the order of the scheduler if it's asked for. With dedup every
+ *    distinct query of a chunk is answered once. Reordered and deduplicated
+ *    chunks are bigger, so that a query has more neighbours and copies;
+ *  - the writer thread formats the answers and writes them out.
+ * So reading, answering and writing overlap, and at most a few chunks are
+ * in memory at once.
+*/
+
+class QueryPipeline final {
+ public:
+  using size_type   = std::size_t;
+  using query_type  = range_query_type;
+  using chunk_type  = std::vector<query_type>;
+  // appends up to max_queries next queries to the chunk, none at the end
+  using source_type = std::function<void(chunk_type &chunk, size_type max_queries)>;
+
+  static constexpr size_type chunk_size           = 1 << 16;
+  static constexpr size_type reordered_chunk_size = 1 << 20;
+  static constexpr size_type queue_capacity       = 4;
+
+  QueryPipeline(source_type source, std::ostream &os,
+                DataFormat output = DataFormat::text,
+                size_type threads_num = default_threads_number(),
+                QueryOrder order = QueryOrder::input, bool dedup = false)
+      : source_ {std::move(source)}, os_ {os}, output_ {output},
+        threads_num_ {threads_num}, order_ {order}, dedup_ {dedup},
+        chunk_size_ {order == QueryOrder::input && !dedup ? chunk_size
+                                                          : reordered_chunk_size},
+        reader_thread_ {[this] { read_queries(); }} {}
+
+  // <queries_num> l1 r1 ..., the reader must be positioned at <queries_num>
+  static source_type text_queries(NumberReader &reader) {
+    return [&reader, queries_num = npos](chunk_type &chunk, size_type max_queries) mutable {
+      if (queries_num == npos) {
+        queries_num = 0;
+        reader.read(queries_num);
+      }
+      for (query_type query; chunk.size() < max_queries && queries_num &&
+                             reader.read(query.first) && reader.read(query.second);) {
+        chunk.push_back(query);
+        --queries_num;
+      }
+    };
+  }
+
+  // the queries section of the binary input
+  static source_type binary_queries(codec::QueryReader &reader) {
+    return [&reader](chunk_type &chunk, size_type max_queries) {
+      reader.read(chunk, max_queries);
+    };
+  }
+
+  QueryPipeline(const QueryPipeline&) = delete;
+  QueryPipeline &operator=(const QueryPipeline&) = delete;
+
+  ~QueryPipeline() {
+    queries_.close();
+  }
+
+  // can be called once, rethrows the first error of the stages
+  template <typename Engine>
+  requires RangeQueryEngine<Engine>
+  void answer(const Engine &engine) {
+    using answers_type = std::vector<answer_type<Engine>>;
+
+    BoundedQueue<answers_type> answers {queue_capacity};
+    std::exception_ptr write_error;
+    std::jthread writer {[&] {
+      try {
+        write_answers(answers);
+      } catch (...) {
+        write_error = std::current_exception();
+        answers.close();
+      }
+    }};
+    while (auto chunk = queries_.pop()) {
+      if (!answers.push(answer_chunk(engine, *chunk))) { break; }
+    }
+    // the reader may wait for a free place if the writer has failed
+    queries_.close();
+    answers.close();
+    writer.join();
+    reader_thread_.join();
+
+    if (read_error_)  { std::rethrow_exception(read_error_); }
+    if (write_error) { std::rethrow_exception(write_error); }
+  }
+
+  // queries answered so far and how many of them were distinct, with dedup
+  size_type queries_number()  const noexcept { return queries_num_; }
+  size_type distinct_number() const noexcept { return distinct_num_; }
+
+ private:
+  template <typename Engine>
+  std::vector<answer_type<Engine>> answer_chunk(const Engine &engine, const chunk_type &chunk) {
+    queries_num_ += chunk.size();
+    if (!dedup_) {
+      distinct_num_ += chunk.size();
+      return ans_queries(engine, chunk, order_, threads_num_);
+    }
+    auto [distinct, index] = dedup_queries(chunk, threads_num_);
+    distinct_num_ += distinct.size();
+    auto distinct_answers = ans_queries(engine, distinct, order_, threads_num_);
+    std::vector<answer_type<Engine>> answers(chunk.size());
+    for (size_type id = 0; id < chunk.size(); ++id) {
+      answers[id] = distinct_answers[index[id]];
+    }
+    return answers;
+  }
+
+  void read_queries() {
+    try {
+      for (chunk_type chunk;; chunk = {}) {
+        chunk.reserve(chunk_size_);
+        source_(chunk, chunk_size_);
+        if (chunk.empty() || !queries_.push(std::move(chunk))) { break; }
+      }
+    } catch (...) {
+      read_error_ = std::current_exception();
+    }
+    queries_.close();
+  }
+
+  template <typename Answers>
+  void write_answers(BoundedQueue<Answers> &answers) {
+    if (output_ == DataFormat::binary) {
+      codec::Writer writer {os_};
+      while (auto chunk = answers.pop()) {
+        codec::write_answers(writer, *chunk);
+      }
+      codec::end_answers(writer);
+      return;
+    }
+    // enough for any integer with the sign and the separator
+    constexpr size_type max_length = 24;
+
+    std::vector<char> buffer;
+    while (auto chunk = answers.pop()) {
+      buffer.resize(chunk->size() * max_length);
+      auto end = buffer.data();
+      for (auto &&answer : *chunk) {
+        end = std::to_chars(end, buffer.data() + buffer.size(), answer).ptr;
+        *end++ = ' ';
+      }
+      os_.write(buffer.data(), end - buffer.data());
+    }
+    os_ << std::endl;
+  }
+
+ private:
+  static constexpr size_type npos = std::numeric_limits<size_type>::max();
+
+  source_type source_;
+  std::ostream &os_;
+  DataFormat output_;
+  size_type threads_num_;
+  QueryOrder order_;
+  bool dedup_;
+  size_type chunk_size_;
+  size_type queries_num_ {0};
+  size_type distinct_num_ {0};
+  BoundedQueue<chunk_type> queries_ {queue_capacity};
+  std::exception_ptr read_error_;
+  std::jthread reader_thread_;
+};
+
+} // <--- namespace yLAB
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+
+#include "range_queries.hpp"
+#include "parallel.hpp"
+
+namespace yLAB {
+
+/*
+ * Offline scheduling of range queries. Random queries touch the tables of an
+ * engine at random addresses; answered in the order of their left borders
+ * (or along the Hilbert curve over (l, r)) neighbouring queries share cache
+ * lines and pages. The order is found with a parallel radix sort of the keys
+ * and the answers are scattered back to the positions of the queries.
+ * Batches with repeated queries can be deduplicated the same way: after the
+ * sort equal queries are neighbours, and each of them is answered once.
+*/
+
+enum class QueryOrder { input, left, hilbert };
+
+// Stable LSD radix sort of the items by key(item) of key_bits bits, 11 bits
+// per pass. Every pass splits the items into threads_num parts: each part
+// counts its digits, and the exclusive prefix sums over (digit, part) give
+// every part its own ranges of the output.
+template <typename T, typename Key>
+void parallel_radix_sort(std::vector<T> &items, unsigned key_bits, Key key,
+                         std::size_t threads_num = default_threads_number()) {
+  using size_type = std::size_t;
+  constexpr unsigned digit_bits = 11;
+  constexpr size_type digits_num = size_type{1} << digit_bits;
+
+  auto size = items.size();
+  threads_num = std::clamp<size_type>(threads_num, 1, std::max<size_type>(size / digits_num, 1));
+  auto part_size = (size + threads_num - 1) / threads_num;
+  std::vector<T> buffer(size);
+  std::vector<std::array<size_type, digits_num>> counts(threads_num);
+  for (unsigned shift = 0; shift < key_bits; shift += digit_bits) {
+    auto digit = [&](const T &item) {
+      return static_cast<size_type>((key(item) >> shift) & (digits_num - 1));
+    };
+    parallel_for(threads_num, threads_num, [&](size_type, size_type part) {
+      counts[part].fill(0);
+      auto end = std::min(size, (part + 1) * part_size);
+      for (auto id = part * part_size; id < end; ++id) {
+        ++counts[part][digit(items[id])];
+      }
+    });
+    size_type offset = 0;
+    for (size_type value = 0; value < digits_num; ++value) {
+      for (auto &&part_counts : counts) {
+        offset += std::exchange(part_counts[value], offset);
+      }
+    }
+    parallel_for(threads_num, threads_num, [&](size_type, size_type part) {
+      auto &positions = counts[part];
+      auto end = std::min(size, (part + 1) * part_size);
+      for (auto id = part * part_size; id < end; ++id) {
+        buffer[positions[digit(items[id])]++] = items[id];
+      }
+    });
+    items.swap(buffer);
+  }
+}
+
+// Position of the cell (x, y) on the Hilbert curve over 2^order x 2^order
+// cells. The quadrants are rotated with masks instead of branches: the bits
+// of random queries don't let the branches be predicted.
+constexpr std::uint64_t hilbert_index(std::uint64_t x, std::uint64_t y, unsigned order) noexcept {
+  std::uint64_t index = 0;
+  for (auto side = (std::uint64_t{1} << order) >> 1; side; side >>= 1) {
+    std::uint64_t rx = (x & side) ? 1 : 0;
+    std::uint64_t ry = (y & side) ? 1 : 0;
+    index += side * side * ((3 * rx) ^ ry);
+    auto low = side - 1;
+    x &= low, y &= low;
+    // reflect the lower left quadrant and transpose both left ones
+    auto reflect = low & -(rx & (ry ^ 1));
+    x ^= reflect, y ^= reflect;
+    auto swap = (x ^ y) & -(ry ^ 1);
+    x ^= swap, y ^= swap;
+  }
+  return index;
+}
+
+// Positions of the queries in the order to answer them. Coordinates are cut
+// to cells of a few thousand elements: the queries of a cell share the
+// cache, and the order within a cell doesn't matter. The key and the
+// position of a query are packed into one word, so the sort moves 8 bytes
+// per query in a couple of passes.
+inline std::vector<std::size_t>
+schedule_queries(const std::vector<range_query_type> &queries, QueryOrder order,
+                 std::size_t threads_num = default_threads_number()) {
+  using size_type = std::size_t;
+  using word_type = std::uint64_t;
+  constexpr unsigned left_bits    = 20;
+  constexpr unsigned hilbert_bits = 10;
+  constexpr size_type chunk_size  = 1 << 16;
+
+  std::vector<size_type> positions(queries.size());
+  if (order == QueryOrder::input || queries.size() < 2) {
+    std::iota(positions.begin(), positions.end(), 0);
+    return positions;
+  }
+
+  auto chunks_num = (queries.size() + chunk_size - 1) / chunk_size;
+  auto for_chunks = [&](auto func) {
+    parallel_for(chunks_num, threads_num, [&](size_type, size_type chunk) {
+      auto end = std::min(queries.size(), (chunk + 1) * chunk_size);
+      for (auto id = chunk * chunk_size; id < end; ++id) {
+        func(chunk, id);
+      }
+    });
+  };
+
+  std::vector<size_type> max_borders(chunks_num, 0);
+  for_chunks([&](size_type chunk, size_type id) {
+    auto [l, r] = queries[id];
+    max_borders[chunk] = std::max({max_borders[chunk], l, r});
+  });
+  unsigned bits    = std::bit_width(*std::max_element(max_borders.begin(), max_borders.end()));
+  unsigned id_bits = std::bit_width(queries.size() - 1);
+  unsigned cells   = std::min({bits, order == QueryOrder::left ? left_bits : hilbert_bits,
+                               order == QueryOrder::left ? 64 - id_bits : (64 - id_bits) / 2});
+  unsigned shift   = bits - cells;
+
+  std::vector<word_type> items(queries.size());
+  for_chunks([&](size_type, size_type id) {
+    auto [l, r] = queries[id];
+    word_type key = (order == QueryOrder::left ? l >> shift
+                                               : hilbert_index(l >> shift, r >> shift, cells));
+    items[id] = key << id_bits | id;
+  });
+  auto key_bits = (order == QueryOrder::left ? cells : 2 * cells);
+  parallel_radix_sort(items, key_bits, [id_bits](word_type item) { return item >> id_bits; },
+                      threads_num);
+  auto id_mask = (word_type{1} << id_bits) - 1;
+  for_chunks([&](size_type, size_type id) { positions[id] = items[id] & id_mask; });
+  return positions;
+}
+
+// The distinct queries of a batch, sorted by (l, r): the query id is
+// answered by distinct[index[id]].
+struct DistinctQueries final {
+  std::vector<range_query_type> distinct;
+  std::vector<std::size_t> index;
+};
+
+// A radix sort by (l, r) brings equal queries together. Both borders are
+// packed into one key if they fit, otherwise the items are sorted by the
+// right borders and then stably by the left ones.
+inline DistinctQueries dedup_queries(const std::vector<range_query_type> &queries,
+                                     std::size_t threads_num = default_threads_number()) {
+  using size_type = std::size_t;
+  using word_type = std::uint64_t;
+
+  DistinctQueries result;
+  result.index.resize(queries.size());
+  if (queries.empty()) { return result; }
+  size_type max_left = 0, max_right = 0;
+  for (auto &&[l, r] : queries) {
+    max_left  = std::max(max_left, l);
+    max_right = std::max(max_right, r);
+  }
+  unsigned left_bits  = std::bit_width(max_left);
+  unsigned right_bits = std::bit_width(max_right);
+
+  auto collect = [&](auto &&items, auto query) {
+    for (auto &&item : items) {
+      if (result.distinct.empty() || result.distinct.back() != query(item)) {
+        result.distinct.push_back(query(item));
+      }
+      result.index[item.id] = result.distinct.size() - 1;
+    }
+  };
+  if (left_bits + right_bits <= 64 && right_bits < 64) {
+    struct Item final {
+      word_type key;
+      size_type id;
+    };
+    std::vector<Item> items(queries.size());
+    for (size_type id = 0; id < queries.size(); ++id) {
+      auto [l, r] = queries[id];
+      items[id] = {(word_type{l} << right_bits) | r, id};
+    }
+    parallel_radix_sort(items, left_bits + right_bits,
+                        [](const Item &item) { return item.key; }, threads_num);
+    auto right_mask = (word_type{1} << right_bits) - 1;
+    collect(items, [&](const Item &item) {
+      return range_query_type {item.key >> right_bits, item.key & right_mask};
+    });
+    return result;
+  }
+
+  struct Item final {
+    range_query_type query;
+    size_type id;
+  };
+  std::vector<Item> items(queries.size());
+  for (size_type id = 0; id < queries.size(); ++id) {
+    items[id] = {queries[id], id};
+  }
+  parallel_radix_sort(items, right_bits,
+                      [](const Item &item) { return item.query.second; }, threads_num);
+  parallel_radix_sort(items, left_bits,
+                      [](const Item &item) { return item.query.first; }, threads_num);
+  collect(items, [](const Item &item) { return item.query; });
+  return result;
+}
+
+// ans_queries in the order of the scheduler, answers are in the order of the queries
+template <typename Engine>
+requires RangeQueryEngine<Engine>
+std::vector<answer_type<Engine>>
+ans_queries(const Engine &engine, const std::vector<range_query_type> &queries,
+            QueryOrder order, std::size_t threads_num = default_threads_number()) {
+  if (order == QueryOrder::input) {
+    return ans_queries(engine, queries, threads_num);
+  }
+  constexpr std::size_t chunk_size = 1 << 12;
+
+  auto positions = schedule_queries(queries, order, threads_num);
+  std::vector<answer_type<Engine>> answers(queries.size());
+  auto chunks_num = (queries.size() + chunk_size - 1) / chunk_size;
+  parallel_for(chunks_num, threads_num, [&](std::size_t, std::size_t chunk) {
+    auto end = std::min(queries.size(), (chunk + 1) * chunk_size);
+    for (auto id = chunk * chunk_size; id < end; ++id) {
+      answers[positions[id]] = engine.ans_query(queries[positions[id]]);
+    }
+  });
+  return answers;
+}
+
+} // <--- namespace yLAB
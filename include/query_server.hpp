@@ -0,0 +1,261 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <utility>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "range_queries.hpp"
+#include "parallel.hpp"
+
+namespace yLAB {
+
+/*
+ * Binary framing of the query server, all the numbers are 64-bit in the byte
+ * order of the host:
+ *   request  - <n> l1 r1 ... ln rn, n == 0 ends the session;
+ *   response - <n> a1 ... an (signed answers in the order of the queries),
+ *              or rejected_batch if a query is out of the array or the batch
+ *              is bigger than max_batch_size; the session ends after it.
+*/
+
+namespace server {
+
+  using word_type = std::uint64_t;
+
+  inline constexpr word_type rejected_batch = std::numeric_limits<word_type>::max();
+  inline constexpr word_type max_batch_size = word_type{1} << 26;
+
+  // false if the other side closed the connection before the first byte
+  inline bool read_all(int fd, void *data, std::size_t size) {
+    auto bytes = static_cast<char*>(data);
+    for (std::size_t done = 0; done < size;) {
+      auto got = ::read(fd, bytes + done, size - done);
+      if (got < 0 && errno == EINTR) { continue; }
+      if (got < 0) {
+        throw std::system_error {errno, std::generic_category(), "read"};
+      }
+      if (got == 0) {
+        if (done == 0) { return false; }
+        throw std::runtime_error {"connection closed in the middle of a frame"};
+      }
+      done += got;
+    }
+    return true;
+  }
+
+  // a closed socket on the other side fails the write instead of SIGPIPE
+  inline void write_all(int fd, const void *data, std::size_t size) {
+    auto bytes = static_cast<const char*>(data);
+    bool socket = true;
+    for (std::size_t done = 0; done < size;) {
+      auto put = socket ? ::send(fd, bytes + done, size - done, MSG_NOSIGNAL)
+                        : ::write(fd, bytes + done, size - done);
+      if (put < 0 && errno == ENOTSOCK) { socket = false; continue; }
+      if (put < 0 && errno == EINTR) { continue; }
+      if (put < 0) {
+        throw std::system_error {errno, std::generic_category(), "write"};
+      }
+      done += put;
+    }
+  }
+
+  inline void send_queries(int fd, const std::vector<range_query_type> &queries) {
+    std::vector<word_type> frame;
+    frame.reserve(2 * queries.size() + 1);
+    frame.push_back(queries.size());
+    for (auto &&[l, r] : queries) {
+      frame.push_back(l);
+      frame.push_back(r);
+    }
+    write_all(fd, frame.data(), frame.size() * sizeof(word_type));
+  }
+
+  inline std::vector<std::int64_t> receive_answers(int fd) {
+    word_type size = 0;
+    if (!read_all(fd, &size, sizeof(size))) {
+      throw std::runtime_error {"the server closed the connection"};
+    }
+    if (size == rejected_batch) {
+      throw std::invalid_argument {"the server rejected the batch"};
+    }
+    std::vector<std::int64_t> answers(size);
+    read_all(fd, answers.data(), size * sizeof(std::int64_t));
+    return answers;
+  }
+
+  inline void end_session(int fd) {
+    word_type end = 0;
+    write_all(fd, &end, sizeof(end));
+  }
+
+  // closes the descriptor when it goes out of scope
+  class FileDescriptor final {
+   public:
+    FileDescriptor(int fd, const char *call) : fd_ {fd} {
+      if (fd_ < 0) {
+        throw std::system_error {errno, std::generic_category(), call};
+      }
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor &operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor() {
+      if (fd_ >= 0) { ::close(fd_); }
+    }
+
+    int get() const noexcept { return fd_; }
+    int release() noexcept { return std::exchange(fd_, -1); }
+   private:
+    int fd_;
+  };
+
+  inline sockaddr_un socket_address(const std::string &path) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+      throw std::invalid_argument {"socket path is too long: " + path};
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+  }
+
+  // the descriptor of the session with the server listening on path
+  inline int connect(const std::string &path) {
+    auto address = socket_address(path);
+    FileDescriptor client {::socket(AF_UNIX, SOCK_STREAM, 0), "socket"};
+    if (::connect(client.get(), reinterpret_cast<const sockaddr*>(&address),
+                  sizeof(address))) {
+      throw std::system_error {errno, std::generic_category(), "connect to " + path};
+    }
+    return client.release();
+  }
+
+  // Removes the socket file a server left behind at path. Anything else at
+  // path, or a socket a live server still listens on, is left as it is.
+  inline void remove_stale_socket(const std::string &path) {
+    struct stat status {};
+    if (::lstat(path.c_str(), &status)) {
+      if (errno == ENOENT) { return; }
+      throw std::system_error {errno, std::generic_category(), "lstat " + path};
+    }
+    if (!S_ISSOCK(status.st_mode)) {
+      throw std::runtime_error {path + " exists and is not a socket"};
+    }
+    auto address = socket_address(path);
+    FileDescriptor probe {::socket(AF_UNIX, SOCK_STREAM, 0), "socket"};
+    if (!::connect(probe.get(), reinterpret_cast<const sockaddr*>(&address),
+                   sizeof(address))) {
+      throw std::runtime_error {"a server already listens on " + path};
+    }
+    if (errno != ECONNREFUSED && errno != ENOENT) {
+      throw std::system_error {errno, std::generic_category(), "connect to " + path};
+    }
+    ::unlink(path.c_str());
+  }
+
+} // <--- namespace server
+
+/*
+ * Keeps a built engine resident and answers query batches from clients, so
+ * the preprocessing is paid once per array instead of once per batch. Every
+ * batch is answered in parallel with ans_queries.
+*/
+
+template <typename Engine>
+requires RangeQueryEngine<Engine>
+class QueryServer final {
+ public:
+  using size_type  = std::size_t;
+  using word_type  = server::word_type;
+  using query_type = range_query_type;
+
+  // engine is built over array_size elements and must outlive the server
+  QueryServer(const Engine &engine, size_type array_size,
+              size_type threads_num = default_threads_number())
+      : engine_ {engine}, array_size_ {array_size}, threads_num_ {threads_num} {}
+
+  // Answers the batches from in_fd to out_fd until the end of the session,
+  // returns the number of answered batches. in_fd and out_fd are the same
+  // socket or two named pipes.
+  size_type serve(int in_fd, int out_fd) const {
+    size_type batches = 0;
+    std::vector<query_type> queries;
+    std::vector<word_type> frame;
+    for (word_type size = 0; server::read_all(in_fd, &size, sizeof(size)) && size;
+         ++batches) {
+      if (size > server::max_batch_size) {
+        reject(out_fd);
+        return batches;
+      }
+      frame.resize(2 * size);
+      server::read_all(in_fd, frame.data(), frame.size() * sizeof(word_type));
+      queries.resize(size);
+      for (size_type id = 0; id < size; ++id) {
+        queries[id] = {frame[2 * id], frame[2 * id + 1]};
+        if (queries[id].first >= array_size_ || queries[id].second >= array_size_) {
+          reject(out_fd);
+          return batches;
+        }
+      }
+
+      auto answers = ans_queries(engine_, queries, threads_num_);
+      frame.resize(size + 1);
+      frame[0] = size;
+      for (size_type id = 0; id < size; ++id) {
+        frame[id + 1] = static_cast<word_type>(static_cast<std::int64_t>(answers[id]));
+      }
+      server::write_all(out_fd, frame.data(), frame.size() * sizeof(word_type));
+    }
+    return batches;
+  }
+
+  // Serves the clients connecting to the UNIX socket at path one after
+  // another, returns after sessions_num sessions. A stale socket file at
+  // path is replaced; other files and live servers' sockets are an error.
+  void listen(const std::string &path,
+              size_type sessions_num = std::numeric_limits<size_type>::max()) const {
+    auto address = server::socket_address(path);
+    server::FileDescriptor listener {::socket(AF_UNIX, SOCK_STREAM, 0), "socket"};
+    server::remove_stale_socket(path);
+    if (::bind(listener.get(), reinterpret_cast<const sockaddr*>(&address),
+               sizeof(address)) || ::listen(listener.get(), SOMAXCONN)) {
+      throw std::system_error {errno, std::generic_category(), "listen on " + path};
+    }
+    for (size_type session = 0; session < sessions_num;) {
+      int fd = ::accept(listener.get(), nullptr, nullptr);
+      if (fd < 0 && errno == EINTR) { continue; }
+      server::FileDescriptor client {fd, "accept"};
+      ++session;
+      try {
+        serve(client.get(), client.get());
+      } catch (const std::exception&) {
+        // a broken session doesn't stop the server
+      }
+    }
+    ::unlink(path.c_str());
+  }
+
+ private:
+  static void reject(int out_fd) {
+    auto answer = server::rejected_batch;
+    server::write_all(out_fd, &answer, sizeof(answer));
+  }
+
+ private:
+  const Engine &engine_;
+  size_type array_size_;
+  size_type threads_num_;
+};
+
+} // <--- namespace yLAB
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+#include <cstddef>
+
+#include "parallel.hpp"
+
+namespace yLAB {
+
+  using range_query_type = std::pair<std::size_t, std::size_t>;
+  // ranges of rows and columns
+  using rectangle_query_type = std::pair<range_query_type, range_query_type>;
+
+  // SparseTable, DisjointSparseTable and RmqSolver answer range_query_type,
+  // 2D engines answer rectangles
+  template <typename Engine, typename Query = range_query_type>
+  concept RangeQueryEngine = requires(const Engine &engine, const Query &query) {
+    engine.ans_query(query);
+  };
+
+  template <typename Engine, typename Query = range_query_type>
+  requires RangeQueryEngine<Engine, Query>
+  using answer_type = std::remove_cvref_t<decltype(std::declval<const Engine&>().
+                                                   ans_query(std::declval<const Query&>()))>;
+
+  // Answers the queries in parallel chunks, answers are in the order of
+  // the queries. Engines are read-only after the construction, so all the
+  // threads share one engine.
+  template <typename Engine, typename Query = range_query_type>
+  requires RangeQueryEngine<Engine, Query>
+  std::vector<answer_type<Engine, Query>>
+  ans_queries(const Engine &engine, const std::vector<Query> &queries,
+              std::size_t threads_num = default_threads_number()) {
+    constexpr std::size_t chunk_size = 1 << 12;
+
+    std::vector<answer_type<Engine, Query>> answers(queries.size());
+    auto chunks_num = (queries.size() + chunk_size - 1) / chunk_size;
+    parallel_for(chunks_num, threads_num, [&](std::size_t, std::size_t chunk) {
+      auto end = std::min(queries.size(), (chunk + 1) * chunk_size);
+      for (auto id = chunk * chunk_size; id < end; ++id) {
+        answers[id] = engine.ans_query(queries[id]);
+      }
+    });
+    return answers;
+  }
+
+} // <--- namespace yLAB
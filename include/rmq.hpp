@@ -1,42 +1,250 @@
 #pragma once
 
-#include <stack>
 #include <vector>
 #include <iterator>
 #include <utility>
-#include <climits>
-#include <bitset>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <initializer_list>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
 
 #include "cartesian_tree.hpp"
+#include "block_table.hpp"
+#include "block_level.hpp"
 #include "sparse_table.hpp"
+#include "memory_usage.hpp"
+#include "index_array.hpp"
 
 namespace yLAB {
 
-template <typename T>
-class RmqSolver final: private SparseTable<std::size_t> {
+template <typename T, typename Allocator = std::allocator<T>,
+          template <typename> class BlockLevel = BlockSparseTable>
+class RmqSolver final {
  public:
-  using value_type  = T;
-  using size_type   = std::size_t;
+  using value_type     = T;
+  using size_type      = std::size_t;
+  using allocator_type = Allocator;
  private:
-  using tree_type   = Treap<value_type>;
-  using sq_table    = std::vector<std::vector<size_type>>;
-  using block_bits  = std::bitset<sizeof(int) * CHAR_BIT>;
+  static constexpr size_type npos = std::numeric_limits<size_type>::max();
+
+  template <typename U>
+  using rebind_alloc  = typename std::allocator_traits<allocator_type>::
+                                                      template rebind_alloc<U>;
+  template <typename U>
+  using vector_type   = std::vector<U, rebind_alloc<U>>;
 
-  using sparse_table = SparseTable<size_type>;
-  using sparse_table::sparse_;
+  using tree_type   = Treap<value_type>;
+  using sparse_type = SparseTable<value_type, allocator_type>;
+  using index_type  = IndexArray<rebind_alloc<size_type>>;
  public:
+  // finds the minimum among whole blocks
+  using block_level_type = BlockLevel<rebind_alloc<size_type>>;
+  // in-block answers are computed on demand together with a lazy block level
+  using sections_type    = std::conditional_t<block_level_type::lazy,
+                                              LazyBlockTable, BlockTable>;
+  using sections_pointer = typename sections_type::pointer;
+
+  // special values of the block_sz constructor argument:
+  // log2(n) / 2 as in the original Farach-Colton and Bender algorithm
+  static constexpr size_type theoretical_block_size = 0;
+  // block size is chosen from n and the cache sizes of the machine
+  static constexpr size_type auto_block_size =
+                                        std::numeric_limits<size_type>::max();
+  static constexpr size_type max_block_size = BlockTable::max_block_size;
+
+  // What answers the queries. If the block size is left to the solver, small
+  // arrays skip the Cartesian tree and the blocks: a flat sparse table is
+  // built and queried several times faster there, and the tiniest arrays
+  // are kept as they are and scanned.
+  enum class Shape { scan, sparse_table, blocks };
+  static constexpr size_type scan_size   = 8;
+  static constexpr size_type sparse_size = 4096;
 
-  RmqSolver(std::initializer_list<value_type> i_list)
-      : RmqSolver(i_list.begin(), i_list.end()) {}
+  static constexpr Shape choose_shape(size_type array_size, size_type block_sz) noexcept {
+    if (block_sz != theoretical_block_size && block_sz != auto_block_size) {
+      return Shape::blocks;
+    }
+    return array_size <= scan_size   ? Shape::scan :
+           array_size <= sparse_size ? Shape::sparse_table : Shape::blocks;
+  }
+
+  RmqSolver(std::initializer_list<value_type> i_list,
+            size_type block_sz = theoretical_block_size,
+            const allocator_type &alloc = allocator_type())
+      : RmqSolver(i_list.begin(), i_list.end(), block_sz, alloc) {}
 
+  // the size of an array given by input iterators is unknown, it takes the blocks
   template <std::input_iterator Iter>
-  RmqSolver(Iter begin, Iter end) {
+  RmqSolver(Iter begin, Iter end, size_type block_sz = theoretical_block_size,
+            const allocator_type &alloc = allocator_type())
+      : euler_tour_(alloc), first_appear_(alloc), heights_(alloc),
+        block_types_(alloc), block_level_(alloc), values_(alloc), sparse_(alloc) {
+    if constexpr (std::forward_iterator<Iter>) {
+      auto array_size = static_cast<size_type>(std::distance(begin, end));
+      shape_ = choose_shape(array_size, block_sz);
+      if (shape_ != Shape::blocks) {
+        block_sz_ = choose_block_size(array_size, block_sz);
+        if (shape_ == Shape::scan) {
+          values_.assign(begin, end);
+        } else {
+          sparse_.construct(begin, end, array_size);
+        }
+        return;
+      }
+    }
     euler_tour(begin, end);
+    block_sz_      = choose_block_size(first_appear_.size(), block_sz);
+    sections_mins_ = sections_type::get(block_sz_);
     rmq_plus_minus_1();
   }
 
+  // the block size is the one of the sections table
+  template <std::input_iterator Iter>
+  RmqSolver(Iter begin, Iter end, sections_pointer sections,
+            const allocator_type &alloc = allocator_type())
+      : euler_tour_(alloc), first_appear_(alloc), heights_(alloc),
+        block_types_(alloc), block_level_(alloc), values_(alloc), sparse_(alloc),
+        sections_mins_ {std::move(sections)},
+        block_sz_ {sections_mins_->block_size()} {
+    euler_tour(begin, end);
+    rmq_plus_minus_1();
+  }
+
+  size_type block_size() const noexcept { return block_sz_; }
+
+  Shape shape() const noexcept { return shape_; }
+
+  // block size of the solver for the array of array_size elements
+  static size_type choose_block_size(size_type array_size,
+                                     size_type block_sz = theoretical_block_size) {
+    if (block_sz > max_block_size && block_sz != auto_block_size) {
+      throw std::invalid_argument {"block size must not exceed " +
+                                   std::to_string(max_block_size) +
+                                   ", got " + std::to_string(block_sz)};
+    }
+    auto euler_size = array_size ? 2 * array_size - 1 : 0;
+    if (block_sz == auto_block_size) {
+      return tuned_block_size(euler_size);
+    }
+    if (block_sz != theoretical_block_size) {
+      return block_sz;
+    }
+    auto log = log2_floor(euler_size);
+    return log > 2 ? log / 2 : 1;
+  }
+
+  // Picks the block size for the euler tour of euler_size elements: the table of
+  // in-block answers has to fit into the half of L2 cache, and among such sizes
+  // the one with the smallest total size of both tables wins.
+  static size_type tuned_block_size(size_type euler_size) {
+    auto cache_limit = cache_sizes.l2 / 2;
+    size_type best_sz = 1;
+    auto best_mem = std::numeric_limits<size_type>::max();
+    for (size_type block_sz = 1; block_sz < max_block_size; ++block_sz) {
+      auto sections_mem = sections_type::memory(block_sz);
+      if (sections_mem > cache_limit) { break; }
+
+      size_type blocks_num = euler_size / block_sz + 1;
+      auto blocks_mem = block_level_type::estimate_memory(blocks_num).total();
+      if (sections_mem + blocks_mem < best_mem) {
+        best_mem = sections_mem + blocks_mem;
+        best_sz  = block_sz;
+      }
+    }
+    return best_sz;
+  }
+
+  // Block size with the smallest estimate_memory(): bigger blocks shrink the
+  // block-level structure, but the in-block table grows exponentially.
+  static size_type lean_block_size(size_type array_size) {
+    size_type best_sz = 1;
+    auto best_mem = std::numeric_limits<size_type>::max();
+    for (size_type block_sz = 1; block_sz < max_block_size; ++block_sz) {
+      if (sections_type::memory(block_sz) >= best_mem) { break; }
+
+      auto memory = estimate_memory(array_size, block_sz).total();
+      if (memory < best_mem) {
+        best_mem = memory;
+        best_sz  = block_sz;
+      }
+    }
+    return best_sz;
+  }
+
+  // the in-block table is shared by all the solvers with the same block size
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    if (shape_ == Shape::scan) {
+      usage.add("values", MemoryUsage::bytes(values_));
+      return usage;
+    }
+    if (shape_ == Shape::sparse_table) {
+      return sparse_.memory_usage();
+    }
+    usage.add("euler tour", MemoryUsage::bytes(euler_tour_));
+    usage.add("first appearances", first_appear_.bytes());
+    usage.add("heights", heights_.bytes());
+    usage.add("block types", MemoryUsage::bytes(block_types_));
+    usage.add(block_level_.memory_usage());
+    usage.add("in-block table", sections_mins_->memory_usage());
+    return usage;
+  }
+
+  // memory_usage() of the solver for the array of array_size elements
+  static MemoryUsage estimate_memory(size_type array_size,
+                                     size_type block_sz = theoretical_block_size) {
+    auto shape = choose_shape(array_size, block_sz);
+    block_sz = choose_block_size(array_size, block_sz);
+    auto euler_size = array_size ? 2 * array_size - 1 : 0;
+    auto blocks_num = (euler_size + block_sz - 1) / block_sz;
+
+    MemoryUsage usage;
+    if (shape == Shape::scan) {
+      usage.add("values", array_size * sizeof(value_type));
+      return usage;
+    }
+    if (shape == Shape::sparse_table) {
+      return sparse_type::estimate_memory(array_size);
+    }
+    usage.add("euler tour", euler_size * sizeof(value_type));
+    // positions in the tour and depths are below its size
+    auto index_size = index_type::index_size(euler_size);
+    usage.add("first appearances", array_size * index_size);
+    usage.add("heights", euler_size * index_size);
+    usage.add("block types", blocks_num * sizeof(size_type));
+    usage.add(block_level_type::estimate_memory(blocks_num));
+    usage.add("in-block table", sections_type::memory(block_sz));
+    return usage;
+  }
+
+  // Peak memory of the construction: it's reached either while the Cartesian
+  // tree is alive (with the worst case stack of its nodes) or at the end,
+  // when minimums of the blocks are still kept.
+  static size_type estimate_peak_memory(size_type array_size,
+                                        size_type block_sz = theoretical_block_size) {
+    auto usage = estimate_memory(array_size, block_sz);
+    if (choose_shape(array_size, block_sz) != Shape::blocks) {
+      return usage.total();
+    }
+    auto tree_memory = array_size * (sizeof(typename tree_type::node_type) +
+                                     sizeof(typename tree_type::pointer));
+    auto tour_memory = usage["euler tour"] + usage["first appearances"] +
+                       usage["heights"];
+    return std::max(tree_memory + tour_memory,
+                    usage.total() + usage["block types"]);
+  }
+
   value_type ans_query(const std::pair<size_type, size_type> &query) const {
+    if (shape_ == Shape::scan) {
+      auto [l, r] = std::minmax(query.first, query.second);
+      return *std::min_element(values_.begin() + l, values_.begin() + r + 1);
+    }
+    if (shape_ == Shape::sparse_table) {
+      return sparse_.ans_query(query);
+    }
     auto [left_id, right_id] = get_heights_positions(query);
     if (left_id > right_id) {
       std::swap(left_id, right_id);
@@ -58,9 +266,7 @@ class RmqSolver final: private SparseTable<std::size_t> {
    auto ansr = block_rmq(right_block, 0, query.second % block_sz_);
    // find the minimum on the blocks between the outer ones, if there are any
    if (left_block + 1 < right_block) {
-     auto power = log2_floor(right_block - left_block - 1);
-     auto ansb  = min(sparse_[left_block + 1][power],
-                      sparse_[right_block - (1 << power)][power]);
+     auto ansb = block_level_.min_pos(left_block + 1, right_block - 1, heights_);
      return min(ansb, min(ansl, ansr));
    }
    return min(ansl, ansr);
@@ -74,65 +280,51 @@ class RmqSolver final: private SparseTable<std::size_t> {
     auto vertex_num      = tree.size();
     auto euler_tour_size = 2 * vertex_num - 1;
     euler_tour_.reserve(euler_tour_size);
-    heights_.reserve(euler_tour_size);
-    first_appear_.assign(vertex_num, -1);
-
-    std::stack<std::pair<typename tree_type::pointer, int>> stack;
+    heights_.reserve(euler_tour_size, euler_tour_size);
+    first_appear_.resize(vertex_num, euler_tour_size);
 
-    auto curr_pair = std::make_pair(tree.root_, 0);
-    // for state: 0 => initial visit, 1 => just did left, 2 => just did right
-    for (size_type state {0}, path {0}; curr_pair.first; ++path) {
-      if (auto key = curr_pair.first->key(); first_appear_[key] == -1) {
-        first_appear_[key] = path;
+    // path from the root to the current node, its size is the depth
+    std::vector<typename tree_type::pointer> path;
+    auto node = tree.root_;
+    // the child we've just come back from, nullptr on the first visit
+    typename tree_type::pointer child = nullptr;
+    for (;;) {
+      if (!child) {
+        first_appear_.set(node->key(), euler_tour_.size());
       }
-      euler_tour_.push_back(curr_pair.first->priority());
-      heights_.push_back(curr_pair.second);
+      euler_tour_.push_back(node->priority());
+      heights_.push_back(path.size());
 
-      if (curr_pair.first->left() && state < 1) {
-        stack.push(curr_pair);
-        curr_pair = std::make_pair(curr_pair.first->left(), curr_pair.second + 1);
-        state = 0;
+      auto next = (!child ? (node->left() ? node->left() : node->right()) :
+                   child == node->left() ? node->right() : nullptr);
+      if (next) {
+        path.push_back(node);
+        node  = next;
+        child = nullptr;
         continue;
       }
-      if (curr_pair.first->right() && state < 2) {
-        stack.push(curr_pair);
-        curr_pair = std::make_pair(curr_pair.first->right(), curr_pair.second + 1);
-        state = 0;
-        continue;
-      }
-
-      if (stack.empty()) { break; }
+      if (path.empty()) { break; }
 
-      auto child = curr_pair.first;
-      curr_pair  = stack.top();
-      stack.pop();
-      state = (child == curr_pair.first->left() ? 1 : 2);
+      child = std::exchange(node, path.back());
+      path.pop_back();
     }
   }
 
   void rmq_plus_minus_1() {
-    if (auto log = log2_floor(heights_.size()); log > 2) {
-      block_sz_ = log / 2;
-    }
-
-    auto min_blocks_pos = get_min_pos_in_each_block();
-    build_sparse_table(min_blocks_pos.begin(), min_blocks_pos.end(),
-                       min_blocks_pos.size());
-    precompute_all_blocks_rmq();
+    block_level_.build(get_min_pos_in_each_block(), heights_);
     compute_each_block_type();
   }
 
-  std::vector<int> get_min_pos_in_each_block() {
+  std::vector<size_type> get_min_pos_in_each_block() {
     size_type size = heights_.size();
     size_type blocks_num = size / block_sz_ + (size % block_sz_ ? 1 : 0);
     block_types_.assign(blocks_num, 0);
-    std::vector<int> blocks_mins(blocks_num, -1);
-    int curr_block = -1;
-    for (size_type id = 0; id < size; ++id) {
-      if (id % block_sz_ == 0) {
+    std::vector<size_type> blocks_mins(blocks_num, npos);
+    for (size_type id = 0, curr_block = 0; id < size; ++id) {
+      if (id != 0 && id % block_sz_ == 0) {
         ++curr_block;
       }
-      if (blocks_mins[curr_block] == -1 ||
+      if (blocks_mins[curr_block] == npos ||
           heights_[blocks_mins[curr_block]] > heights_[id]) {
         blocks_mins[curr_block] = id;
       }
@@ -147,77 +339,18 @@ class RmqSolver final: private SparseTable<std::size_t> {
         j = 0, ++curr_block;
       }
       if (j > 0 && (i >= size || heights_[i - 1] < heights_[i])) {
-        block_types_[curr_block] += (1 << (j - 1));
-      }
-    }
-  }
-
-  void precompute_all_blocks_rmq() {
-    // we have 2^(block_sz - 1)  different blocks
-    size_type diff_blocks = 1 << (block_sz_ - 1);
-    sections_mins_.assign(diff_blocks, sq_table(block_sz_,
-                                                std::vector<size_type>(block_sz_)));
-    for (size_type i = 0; i < diff_blocks; ++i) {
-      auto section = get_block_section(i);
-      for (size_type j = 0; j < block_sz_; ++j) {
-        int min = section[j], min_id = j;
-        sections_mins_[i][j][j] = j;
-        for (size_type k = j + 1; k < block_sz_; ++k) {
-          if (min < section[k]) {
-            sections_mins_[i][j][k] = min_id;
-          } else {
-            sections_mins_[i][j][k] = min_id = k;
-            min = section[min_id];
-          }
-        }
-      }
-    }
-  }
-
-  template <std::input_iterator Iter>
-  void build_sparse_table(Iter begin, Iter end, size_type size) {
-    size_type log = log2_floor(size);
-    sparse_.resize(size, std::vector<size_type>(log + 1));
-
-    for (int i = 0; begin != end; ++begin, ++i) {
-      sparse_[i][0] = *begin;
-    }
-    for (size_type j = 1; j <= log; ++j) {
-      for (size_type i = 0; i < size; ++i) {
-        size_type ind = (1 << (j - 1)) + i;
-        if (ind >= size) {
-          sparse_[i][j] = sparse_[i][j - 1];
-        }
-        else if (heights_[sparse_[i][j - 1]] > heights_[sparse_[ind][j - 1]]) {
-          sparse_[i][j] = sparse_[ind][j - 1];
-        }
-        else {
-          sparse_[i][j] = sparse_[i][j - 1];
-        }
+        block_types_[curr_block] += (size_type{1} << (j - 1));
       }
     }
   }
 
-  std::vector<int> get_block_section(size_type block_id) const {
-    block_bits b_set(block_id);
-    std::vector section(block_sz_, 0);
-    int assign = 0;
-    for (size_type i = 1; i < block_sz_; ++i) {
-      if (b_set[i - 1] == 0) {
-        section[i] = --assign;
-      } else {
-        section[i] = ++assign;
-      }
-    }
-    return section;
-  }
-
   size_type min(size_type l, size_type r) const {
     return heights_[l] < heights_[r] ? l : r;
   }
 
   size_type block_rmq(size_type block_num, size_type l, size_type r) const {
-    return sections_mins_[block_types_[block_num]][l][r] + block_num * block_sz_;
+    return sections_mins_->min_pos(block_types_[block_num], l, r) +
+           block_num * block_sz_;
   }
 
   std::pair<size_type, size_type>
@@ -227,16 +360,29 @@ class RmqSolver final: private SparseTable<std::size_t> {
   }
 
  private:
-  std::vector<value_type> euler_tour_;
-  std::vector<int> first_appear_;
-  std::vector<size_type> heights_;
-  std::vector<size_type> block_types_;
-  std::vector<sq_table>  sections_mins_;
+  vector_type<value_type> euler_tour_;
+  index_type first_appear_;
+  index_type heights_;
+  vector_type<size_type> block_types_;
+  block_level_type block_level_;
+  // the small array engines
+  vector_type<value_type> values_;
+  sparse_type sparse_;
+  Shape shape_ {Shape::blocks};
+  sections_pointer sections_mins_;
   size_type block_sz_ {1};
 };
 
 template <std::input_iterator Iter>
 RmqSolver(Iter, Iter) -> RmqSolver<typename std::iterator_traits<Iter>::value_type>;
 
+template <std::input_iterator Iter>
+RmqSolver(Iter, Iter, std::size_t) ->
+                     RmqSolver<typename std::iterator_traits<Iter>::value_type>;
+
+template <std::input_iterator Iter, typename Allocator>
+RmqSolver(Iter, Iter, std::size_t, Allocator) ->
+          RmqSolver<typename std::iterator_traits<Iter>::value_type, Allocator>;
+
 } // <--- namespace yLAB
 
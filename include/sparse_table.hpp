@@ -5,36 +5,74 @@
 #include <iterator>
 #include <utility>
 #include <vector>
+#include <array>
+#include <memory>
 #include <cmath>
 
 #include "utils.hpp"
+#include "memory_usage.hpp"
 
 namespace yLAB {
 
-template <typename T>
+template <typename T, typename Allocator = std::allocator<T>>
 class SparseTable {
  public:
-  using size_type   = std::size_t;
-  using value_type  = T;
-  using sparse_type = std::vector<std::vector<value_type>>;
+  using size_type      = std::size_t;
+  using value_type     = T;
+  using allocator_type = Allocator;
+ protected:
+  template <typename U>
+  using rebind_alloc   = typename std::allocator_traits<allocator_type>::
+                                                      template rebind_alloc<U>;
+  using row_type       = std::vector<value_type, allocator_type>;
+ public:
+  using sparse_type    = std::vector<row_type, rebind_alloc<row_type>>;
 
   constexpr SparseTable() = default;
 
-  constexpr SparseTable(std::initializer_list<value_type> i_list)
-      : SparseTable(i_list.begin(), i_list.end(), i_list.size()) {}
+  constexpr explicit SparseTable(const allocator_type &alloc)
+      : sparse_(alloc) {}
+
+  constexpr SparseTable(std::initializer_list<value_type> i_list,
+                        const allocator_type &alloc = allocator_type())
+      : SparseTable(i_list.begin(), i_list.end(), i_list.size(), alloc) {}
 
   template <std::input_iterator Iter>
-  constexpr SparseTable(Iter begin, Iter end, size_type n) {
+  constexpr SparseTable(Iter begin, Iter end, size_type n,
+                        const allocator_type &alloc = allocator_type())
+      : sparse_(alloc) {
     construct(begin, end, n);
   }
 
   virtual ~SparseTable() = default;
 
   constexpr value_type min(const std::pair<size_type, size_type> &query) const {
-    int i = log2_floor(query.second - query.first + 1);
+    size_type i = log2_floor(query.second - query.first + 1);
 
     return std::min(sparse_[i][query.first],
-                    sparse_[i][query.second - (1 << i) + 1]);
+                    sparse_[i][query.second - (size_type{1} << i) + 1]);
+  }
+
+  // the same interface as RmqSolver: borders may come in any order
+  constexpr value_type ans_query(std::pair<size_type, size_type> query) const {
+    if (query.first > query.second) {
+      std::swap(query.first, query.second);
+    }
+    return min(query);
+  }
+
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("sparse table", rows_memory(sparse_));
+    return usage;
+  }
+
+  // memory_usage() of the table of n elements
+  static MemoryUsage estimate_memory(size_type n) {
+    MemoryUsage usage;
+    size_type rows_num = n ? log2_floor(n) + 1 : 0;
+    usage.add("sparse table", rows_num * (sizeof(row_type) + n * sizeof(value_type)));
+    return usage;
   }
 
   template <std::input_iterator Iter>
@@ -42,18 +80,28 @@ class SparseTable {
     if (n == 0) return;
 
     size_type log = log2_floor(n);
-    sparse_.resize(log + 1, std::vector<value_type>(n));
+    sparse_.resize(log + 1, row_type(n, sparse_.get_allocator()));
 
     std::copy(begin, end, sparse_[0].begin());
 
     for (size_type i = 0; i < log; ++i) {
       for (size_type j = 0; j < n; ++j) {
-        size_type k = std::min(n - 1, j + (1 << i));
+        size_type k = std::min(n - 1, j + (size_type{1} << i));
         sparse_[i + 1][j] = std::min(sparse_[i][j], sparse_[i][k]);
       }
     }
   }
 
+ protected:
+  template <typename Table>
+  static size_type rows_memory(const Table &table) noexcept {
+    auto memory = MemoryUsage::bytes(table);
+    for (auto &&row : table) {
+      memory += MemoryUsage::bytes(row);
+    }
+    return memory;
+  }
+
  protected:
   sparse_type sparse_;
 };
@@ -62,5 +110,61 @@ template <std::input_iterator Iter>
 SparseTable(Iter, Iter, std::size_t) ->
                    SparseTable<typename std::iterator_traits<Iter>::value_type>;
 
+template <std::input_iterator Iter, typename Allocator>
+SparseTable(Iter, Iter, std::size_t, Allocator) ->
+        SparseTable<typename std::iterator_traits<Iter>::value_type, Allocator>;
+
+// SparseTable of N elements known at compile time. The rows are arrays, so
+// a table built in a constant expression is baked into the binary:
+//   constexpr StaticSparseTable table {std::array {3, 1, 4, 1, 5}};
+//   static_assert(table.min({2, 4}) == 1);
+template <typename T, std::size_t N>
+class StaticSparseTable final {
+ public:
+  using size_type  = std::size_t;
+  using value_type = T;
+
+  static constexpr size_type rows_num = N ? log2_floor(N) + 1 : 0;
+
+  constexpr explicit StaticSparseTable(const std::array<value_type, N> &array)
+      : StaticSparseTable(array.begin(), array.end()) {}
+
+  // the first N elements of [begin, end)
+  template <std::input_iterator Iter>
+  constexpr StaticSparseTable(Iter begin, Iter end) {
+    for (size_type j = 0; j < N && begin != end; ++j, ++begin) {
+      sparse_[0][j] = *begin;
+    }
+    for (size_type i = 0; i + 1 < rows_num; ++i) {
+      for (size_type j = 0; j < N; ++j) {
+        size_type k = std::min(N - 1, j + (size_type{1} << i));
+        sparse_[i + 1][j] = std::min(sparse_[i][j], sparse_[i][k]);
+      }
+    }
+  }
+
+  static constexpr size_type size() noexcept { return N; }
+
+  constexpr value_type min(const std::pair<size_type, size_type> &query) const {
+    size_type i = log2_floor(query.second - query.first + 1);
+
+    return std::min(sparse_[i][query.first],
+                    sparse_[i][query.second - (size_type{1} << i) + 1]);
+  }
+
+  constexpr value_type ans_query(std::pair<size_type, size_type> query) const {
+    if (query.first > query.second) {
+      std::swap(query.first, query.second);
+    }
+    return min(query);
+  }
+
+ private:
+  std::array<std::array<value_type, N>, rows_num> sparse_ {};
+};
+
+template <typename T, std::size_t N>
+StaticSparseTable(const std::array<T, N>&) -> StaticSparseTable<T, N>;
+
 } // <--- namespace yLAB
 
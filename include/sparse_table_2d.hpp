@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+#include "utils.hpp"
+#include "memory_usage.hpp"
+#include "range_queries.hpp"
+
+namespace yLAB {
+
+/*
+ * Minimum over a rectangle of a matrix in O(1). It's the 1D sparse table
+ * applied twice: plane (a, b) keeps the minimums of the 2^a x 2^b rectangles
+ * starting at every cell, and a query is covered by four overlapping
+ * rectangles of one plane. Planes of rows x columns cells are kept one after
+ * another in one flat array, plane (0, 0) is the matrix itself.
+*/
+
+template <typename T, typename Allocator = std::allocator<T>>
+class SparseTable2D final {
+ public:
+  using size_type      = std::size_t;
+  using value_type     = T;
+  using allocator_type = Allocator;
+  using query_type     = rectangle_query_type;
+  using table_type     = std::vector<value_type, allocator_type>;
+
+  explicit SparseTable2D(const allocator_type &alloc = allocator_type())
+      : table_(alloc) {}
+
+  // row-major matrix with cols columns
+  template <std::input_iterator Iter>
+  SparseTable2D(Iter begin, Iter end, size_type cols,
+                const allocator_type &alloc = allocator_type())
+      : table_(alloc) {
+    table_.assign(begin, end);
+    if (table_.empty()) { return ; }
+    if (cols == 0 || table_.size() % cols) {
+      throw std::invalid_argument {std::to_string(table_.size()) +
+                                   " elements don't make a matrix with " +
+                                   std::to_string(cols) + " columns"};
+    }
+    rows_ = table_.size() / cols, cols_ = cols;
+    row_levels_ = log2_floor(rows_) + 1;
+    col_levels_ = log2_floor(cols_) + 1;
+    auto table_size = row_levels_ * col_levels_ * rows_ * cols_;
+    table_.reserve(table_size);
+    table_.resize(table_size);
+    build();
+  }
+
+  value_type ans_query(const query_type &query) const {
+    auto [rows, cols] = query;
+    if (rows.first > rows.second) { std::swap(rows.first, rows.second); }
+    if (cols.first > cols.second) { std::swap(cols.first, cols.second); }
+
+    auto row_level = log2_floor(rows.second - rows.first + 1);
+    auto col_level = log2_floor(cols.second - cols.first + 1);
+    auto plane = table_.data() + this->plane(row_level, col_level);
+    auto top    = rows.first * cols_;
+    auto bottom = (rows.second + 1 - (size_type{1} << row_level)) * cols_;
+    auto left   = cols.first;
+    auto right  = cols.second + 1 - (size_type{1} << col_level);
+    return std::min(std::min(plane[top + left], plane[top + right]),
+                    std::min(plane[bottom + left], plane[bottom + right]));
+  }
+
+  size_type rows() const noexcept { return rows_; }
+  size_type cols() const noexcept { return cols_; }
+
+  MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.add("2d sparse table", MemoryUsage::bytes(table_));
+    return usage;
+  }
+
+  // memory_usage() of the table of rows x cols matrix
+  static MemoryUsage estimate_memory(size_type rows, size_type cols) {
+    MemoryUsage usage;
+    usage.add("2d sparse table", rows && cols ? (log2_floor(rows) + 1) *
+                                                (log2_floor(cols) + 1) *
+                                                rows * cols * sizeof(value_type) : 0);
+    return usage;
+  }
+
+ private:
+  size_type plane(size_type row_level, size_type col_level) const noexcept {
+    return (row_level * col_levels_ + col_level) * rows_ * cols_;
+  }
+
+  // planes (0, b) are 1D sparse tables of the rows, planes (a, b) are
+  // built from (a - 1, b) by columns
+  void build() {
+    for (size_type level = 1; level < col_levels_; ++level) {
+      auto prev = table_.begin() + plane(0, level - 1);
+      auto next = table_.begin() + plane(0, level);
+      auto half = size_type{1} << (level - 1);
+      for (size_type row = 0; row < rows_ * cols_; row += cols_) {
+        for (size_type col = 0; col < cols_; ++col) {
+          next[row + col] = std::min(prev[row + col],
+                                     prev[row + std::min(cols_ - 1, col + half)]);
+        }
+      }
+    }
+    for (size_type level = 1; level < row_levels_; ++level) {
+      auto half = size_type{1} << (level - 1);
+      for (size_type col_level = 0; col_level < col_levels_; ++col_level) {
+        auto prev = table_.begin() + plane(level - 1, col_level);
+        auto next = table_.begin() + plane(level, col_level);
+        for (size_type row = 0; row < rows_; ++row) {
+          auto lower = std::min(rows_ - 1, row + half) * cols_;
+          for (size_type col = 0; col < cols_; ++col) {
+            next[row * cols_ + col] = std::min(prev[row * cols_ + col],
+                                               prev[lower + col]);
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  table_type table_;
+  size_type rows_ {0};
+  size_type cols_ {0};
+  size_type row_levels_ {0};
+  size_type col_levels_ {0};
+};
+
+template <std::input_iterator Iter>
+SparseTable2D(Iter, Iter, std::size_t) ->
+                 SparseTable2D<typename std::iterator_traits<Iter>::value_type>;
+
+} // <--- namespace yLAB
+
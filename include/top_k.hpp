@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <cstddef>
+
+#include "rmq.hpp"
+#include "range_queries.hpp"
+#include "parallel.hpp"
+
+namespace yLAB {
+
+/*
+ * k smallest values of a range. RmqSolver is built over the pairs (a[i], i),
+ * so its minimum is also the position of the minimum, the leftmost one among
+ * equal values. The minimum at m splits [l, r] into [l, m - 1] and
+ * [m + 1, r]: a heap of such ranges keyed by their minimums gives the k
+ * smallest values with at most 2k queries to the solver, O(k log k) in total.
+*/
+
+template <typename T, typename Allocator = std::allocator<T>>
+class RangeTopK final {
+ public:
+  using size_type      = std::size_t;
+  using value_type     = T;
+  using allocator_type = Allocator;
+  // the value and its position in the array
+  using element_type   = std::pair<value_type, size_type>;
+  using solver_type    = RmqSolver<element_type, typename std::allocator_traits<
+                                   allocator_type>::template rebind_alloc<element_type>>;
+  using query_type     = std::pair<size_type, size_type>;
+
+  template <std::forward_iterator Iter>
+  RangeTopK(Iter begin, Iter end, size_type block_sz = solver_type::theoretical_block_size,
+            const allocator_type &alloc = allocator_type())
+      : solver_ {make_solver(begin, end, block_sz, alloc)} {}
+
+  // the minimum of the range, so RangeTopK works with ans_queries too
+  value_type ans_query(const query_type &query) const {
+    return solver_.ans_query(query).first;
+  }
+
+  // the leftmost minimum of the range with its position
+  element_type min_element(const query_type &query) const {
+    return solver_.ans_query(query);
+  }
+
+  // Up to k smallest elements of the range in ascending order, equal values
+  // by position. Borders may come in any order.
+  std::vector<element_type> top_k(query_type query, size_type k) const {
+    std::vector<element_type> result;
+    std::vector<Range> heap;
+    top_k(query, k, result, heap);
+    return result;
+  }
+
+  // top_k() of every query, in parallel chunks sharing the solver
+  std::vector<std::vector<element_type>>
+  top_k(const std::vector<query_type> &queries, size_type k,
+        size_type threads_num = default_threads_number()) const {
+    constexpr size_type chunk_size = 1 << 10;
+
+    std::vector<std::vector<element_type>> results(queries.size());
+    auto chunks_num = (queries.size() + chunk_size - 1) / chunk_size;
+    parallel_for(chunks_num, threads_num, [&](size_type, size_type chunk) {
+      std::vector<Range> heap;
+      auto end = std::min(queries.size(), (chunk + 1) * chunk_size);
+      for (auto id = chunk * chunk_size; id < end; ++id) {
+        top_k(queries[id], k, results[id], heap);
+      }
+    });
+    return results;
+  }
+
+  const solver_type &solver() const noexcept { return solver_; }
+
+  MemoryUsage memory_usage() const { return solver_.memory_usage(); }
+
+ private:
+  // a part of the query with its minimum
+  struct Range final {
+    element_type min;
+    size_type left;
+    size_type right;
+
+    bool operator>(const Range &rhs) const { return min > rhs.min; }
+  };
+
+  template <typename Iter>
+  static solver_type make_solver(Iter begin, Iter end, size_type block_sz,
+                                 const allocator_type &alloc) {
+    std::vector<element_type> elements;
+    elements.reserve(std::distance(begin, end));
+    for (size_type id = 0; begin != end; ++begin, ++id) {
+      elements.emplace_back(*begin, id);
+    }
+    return solver_type(elements.begin(), elements.end(), block_sz, alloc);
+  }
+
+  void top_k(query_type query, size_type k, std::vector<element_type> &result,
+             std::vector<Range> &heap) const {
+    auto [l, r] = std::minmax(query.first, query.second);
+    result.clear();
+    heap.clear();
+    result.reserve(std::min(k, r - l + 1));
+    if (k == 0) { return; }
+
+    heap.push_back({solver_.ans_query({l, r}), l, r});
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+      auto [min, left, right] = heap.back();
+      heap.pop_back();
+      result.push_back(min);
+      if (result.size() == k) { break; }
+
+      auto pos = min.second;
+      if (pos > left) {
+        heap.push_back({solver_.ans_query({left, pos - 1}), left, pos - 1});
+        std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+      }
+      if (pos < right) {
+        heap.push_back({solver_.ans_query({pos + 1, right}), pos + 1, right});
+        std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+      }
+    }
+  }
+
+ private:
+  solver_type solver_;
+};
+
+template <std::forward_iterator Iter>
+RangeTopK(Iter, Iter) -> RangeTopK<typename std::iterator_traits<Iter>::value_type>;
+
+template <std::forward_iterator Iter>
+RangeTopK(Iter, Iter, std::size_t) ->
+                     RangeTopK<typename std::iterator_traits<Iter>::value_type>;
+
+} // <--- namespace yLAB
@@ -2,6 +2,9 @@
 
 #include <bit>
 #include <concepts>
+#include <cstddef>
+
+#include <unistd.h>
 
 namespace yLAB {
 
@@ -10,5 +13,27 @@ namespace yLAB {
     return std::bit_width(number) - 1;
   }
 
+  struct CacheSizes final {
+    std::size_t l1;
+    std::size_t l2;
+  };
+
+  inline CacheSizes detect_cache_sizes() noexcept {
+    // typical values, used if the system doesn't report them
+    CacheSizes sizes {32 * 1024, 256 * 1024};
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+    if (auto l1 = ::sysconf(_SC_LEVEL1_DCACHE_SIZE); l1 > 0) {
+      sizes.l1 = static_cast<std::size_t>(l1);
+    }
+    if (auto l2 = ::sysconf(_SC_LEVEL2_CACHE_SIZE); l2 > 0) {
+      sizes.l2 = static_cast<std::size_t>(l2);
+    }
+#endif
+    return sizes;
+  }
+
+  // detected once at startup
+  inline const CacheSizes cache_sizes = detect_cache_sizes();
+
 } // <--- namespace yLAB
 
@@ -2,38 +2,459 @@
 #include <stdexcept>
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <fstream>
+#include <variant>
+#include <limits>
+#include <cstdint>
+#include <optional>
+#include <array>
 
 #include "rmq.hpp"
+#include "sparse_table.hpp"
+#include "huge_page_allocator.hpp"
+#include "batch_solver.hpp"
+#include "sparse_table_2d.hpp"
+#include "block_rmq_2d.hpp"
+#include "range_queries.hpp"
+#include "query_server.hpp"
+#include "number_reader.hpp"
+#include "pipeline.hpp"
+#include "codec.hpp"
 
 namespace {
 
-  auto get_data(std::istream &is) { 
-    std::vector<int> array;
-    std::vector<int> queries;
-    std::vector<int> data;
-    
-    std::copy(std::istream_iterator<int>(is), std::istream_iterator<int>(),
-              std::back_inserter(data));
-    
-    auto begin = data.begin();
-    std::copy_n(std::next(begin), *begin, std::back_inserter(array));
-    std::advance(begin, *begin + 1);
-    std::copy_n(std::next(begin), *begin * 2, std::back_inserter(queries));
- 
-    return std::make_pair(array, queries);
+  template <typename T>
+  using allocator_type = yLAB::HugePageAllocator<T>;
+  template <typename T>
+  using solver_type    = yLAB::RmqSolver<T, allocator_type<T>>;
+  template <typename T>
+  using sparse_type    = yLAB::SparseTable<T, allocator_type<T>>;
+  template <typename T>
+  using lazy_solver_type = yLAB::RmqSolver<T, allocator_type<T>,
+                                           yLAB::LazyBlockSparseTable>;
+
+  using narrow_type = std::int32_t;
+  using wide_type   = std::int64_t;
+
+  // values are kept in 32 bits until the first one which doesn't fit,
+  // next(value) gives the values one by one
+  template <typename Next>
+  std::variant<std::vector<narrow_type>, std::vector<wide_type>>
+  get_array(std::size_t size, Next next) {
+    std::vector<narrow_type> narrow;
+    narrow.reserve(size);
+    for (wide_type value = 0; narrow.size() < size && next(value);) {
+      if (value < std::numeric_limits<narrow_type>::min() ||
+          value > std::numeric_limits<narrow_type>::max()) {
+        std::vector<wide_type> wide;
+        wide.reserve(size);
+        wide.assign(narrow.begin(), narrow.end());
+        std::vector<narrow_type>().swap(narrow);
+        wide.push_back(value);
+        while (wide.size() < size && next(value)) {
+          wide.push_back(value);
+        }
+        return wide;
+      }
+      narrow.push_back(value);
+    }
+    return narrow;
+  }
+
+  struct Options final {
+    std::size_t block_sz = solver_type<narrow_type>::theoretical_block_size;
+    yLAB::Pages pages = yLAB::Pages::transparent;
+    yLAB::NumaPolicy numa = yLAB::NumaPolicy::local;
+    std::size_t threads_num = yLAB::default_threads_number();
+    bool batch = false;
+    bool matrix = false;
+    std::size_t memory_limit = std::numeric_limits<std::size_t>::max();
+    bool memory_report = false;
+    bool lazy = false;
+    std::string socket;
+    std::string connect;
+    yLAB::DataFormat input = yLAB::DataFormat::text;
+    yLAB::DataFormat output = yLAB::DataFormat::text;
+    bool encode = false;
+    bool decode = false;
+    yLAB::QueryOrder order = yLAB::QueryOrder::input;
+    bool dedup = false;
+  };
+
+  // <number>[K|M|G]
+  std::size_t get_bytes(std::string_view value) {
+    // stoull would take a negative number modulo 2^64
+    if (value.starts_with('-')) {
+      throw std::invalid_argument {"negative size: " + std::string(value)};
+    }
+    std::size_t pos = 0;
+    std::size_t bytes = std::stoull(std::string(value), &pos);
+    auto suffix = value.substr(pos);
+    for (auto [unit, shift] : {std::pair{"K", 10}, {"M", 20}, {"G", 30}}) {
+      if (suffix == unit) {
+        if (bytes > (std::numeric_limits<std::size_t>::max() >> shift)) {
+          throw std::out_of_range {"size is too big: " + std::string(value)};
+        }
+        return bytes << shift;
+      }
+    }
+    if (!suffix.empty()) {
+      throw std::invalid_argument {"unknown size suffix: " + std::string(suffix)};
+    }
+    return bytes;
+  }
+
+  // --block-size=<number|auto> --huge-pages=<off|thp|hugetlb> --numa=<local|interleave>
+  // --threads=<number> --batch --matrix --memory-limit=<number>[K|M|G] --memory-report
+  // --lazy --serve=<socket> --connect=<socket> --input=<text|binary>
+  // --output=<text|binary> --encode --decode --reorder=<input|left|hilbert> --dedup
+  Options get_options(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+      std::string_view arg {argv[i]};
+      auto value = arg.substr(arg.find('=') + 1);
+      if (arg.starts_with("--block-size=")) {
+        options.block_sz = (value == "auto" ? solver_type<narrow_type>::auto_block_size
+                                            : std::stoul(std::string(value)));
+      } else if (arg.starts_with("--huge-pages=") &&
+                 (value == "off" || value == "thp" || value == "hugetlb")) {
+        options.pages = (value == "off" ? yLAB::Pages::usual :
+                         value == "thp" ? yLAB::Pages::transparent :
+                                          yLAB::Pages::hugetlb);
+      } else if (arg.starts_with("--numa=") &&
+                 (value == "local" || value == "interleave")) {
+        options.numa = (value == "local" ? yLAB::NumaPolicy::local
+                                         : yLAB::NumaPolicy::interleave);
+      } else if (arg.starts_with("--threads=")) {
+        options.threads_num = std::stoul(std::string(value));
+      } else if (arg == "--batch") {
+        options.batch = true;
+      } else if (arg == "--matrix") {
+        options.matrix = true;
+      } else if (arg.starts_with("--memory-limit=")) {
+        options.memory_limit = get_bytes(value);
+      } else if (arg == "--memory-report") {
+        options.memory_report = true;
+      } else if (arg == "--lazy") {
+        options.lazy = true;
+      } else if (arg.starts_with("--serve=")) {
+        options.socket = value;
+      } else if (arg.starts_with("--connect=")) {
+        options.connect = value;
+      } else if ((arg.starts_with("--input=") || arg.starts_with("--output=")) &&
+                 (value == "text" || value == "binary")) {
+        (arg.starts_with("--input=") ? options.input : options.output) =
+            (value == "text" ? yLAB::DataFormat::text : yLAB::DataFormat::binary);
+      } else if (arg == "--encode") {
+        options.encode = true;
+      } else if (arg == "--decode") {
+        options.decode = true;
+      } else if (arg.starts_with("--reorder=") &&
+                 (value == "input" || value == "left" || value == "hilbert")) {
+        options.order = (value == "input" ? yLAB::QueryOrder::input :
+                         value == "left"  ? yLAB::QueryOrder::left :
+                                            yLAB::QueryOrder::hilbert);
+      } else if (arg == "--dedup") {
+        options.dedup = true;
+      } else {
+        throw std::invalid_argument {"unknown option: " + std::string(arg)};
+      }
+    }
+    return options;
+  }
+
+  // engines from the fastest to the leanest one
+  enum class Engine { sparse_table, blocks, lean_blocks };
+
+  // Picks the fastest engine which fits into the memory limit together with
+  // the input array, which is alive during the construction.
+  template <typename T>
+  Engine choose_engine(std::size_t array_size, const Options &options) {
+    if (options.memory_limit == std::numeric_limits<std::size_t>::max()) {
+      return Engine::blocks;
+    }
+    auto needed = [&](std::size_t memory) { return memory + array_size * sizeof(T); };
+    auto sparse_mem = needed(sparse_type<T>::estimate_memory(array_size).total());
+    auto blocks_mem = needed(solver_type<T>::estimate_peak_memory(array_size,
+                                                                  options.block_sz));
+    auto lean_mem   = needed(solver_type<T>::estimate_peak_memory(
+                             array_size, solver_type<T>::lean_block_size(array_size)));
+    if (sparse_mem <= options.memory_limit) { return Engine::sparse_table; }
+    if (blocks_mem <= options.memory_limit) { return Engine::blocks; }
+    if (lean_mem <= options.memory_limit)   { return Engine::lean_blocks; }
+    throw std::length_error {"memory limit of " + std::to_string(options.memory_limit) +
+                             " bytes is less than " + std::to_string(lean_mem) +
+                             " bytes needed"};
+  }
+
+  // builds the engine picked by the options and passes it to use(engine, name)
+  template <typename T, typename Func>
+  void with_engine(std::vector<T> &&array, const Options &options, Func use) {
+    auto engine = choose_engine<T>(array.size(), options);
+    allocator_type<T> alloc {options.pages, options.numa};
+    auto block_sz = (engine == Engine::lean_blocks ?
+                     solver_type<T>::lean_block_size(array.size()) : options.block_sz);
+    // the sparse table is skipped: its O(n log n) build is what --lazy avoids
+    if (options.lazy) {
+      lazy_solver_type<T> rmq(array.begin(), array.end(), block_sz, alloc);
+      std::vector<T>().swap(array);
+      use(rmq, "lazy blocks");
+      return;
+    }
+    if (engine == Engine::sparse_table) {
+      sparse_type<T> sparse(array.begin(), array.end(), array.size(), alloc);
+      std::vector<T>().swap(array);
+      use(sparse, "sparse table");
+      return;
+    }
+    solver_type<T> rmq(array.begin(), array.end(), block_sz, alloc);
+    std::vector<T>().swap(array);
+    use(rmq, engine == Engine::blocks ? "blocks" : "lean blocks");
+  }
+
+  template <typename Engine>
+  void report(const Engine &engine, std::string_view name, const Options &options) {
+    if (options.memory_report) {
+      std::cerr << "engine: " << name << '\n' << engine.memory_usage();
+    }
+  }
+
+  // batches of queries from is in the usual format, <queries_num> l1 r1 ...,
+  // are sent to the server, answers to each batch are printed on a separate line
+  void ask_server(std::istream &is, std::ostream &os, const Options &options) {
+    yLAB::server::FileDescriptor session {yLAB::server::connect(options.connect),
+                                          "connect"};
+    std::vector<yLAB::range_query_type> queries;
+    for (std::size_t queries_num = 0; is >> queries_num;) {
+      queries.resize(queries_num);
+      for (auto &&[l, r] : queries) {
+        if (!(is >> l >> r)) {
+          throw std::runtime_error {"the batch of " + std::to_string(queries_num) +
+                                    " queries is cut off or has an invalid border"};
+        }
+      }
+      // n == 0 ends the session, so an empty batch isn't sent
+      if (!queries.empty()) {
+        yLAB::server::send_queries(session.get(), queries);
+        for (auto &&answer : yLAB::server::receive_answers(session.get())) {
+          os << answer << ' ';
+        }
+      }
+      os << '\n';
+    }
+    if (!is.eof()) {
+      throw std::runtime_error {"invalid number of queries in a batch"};
+    }
+    yLAB::server::end_session(session.get());
+    os << std::flush;
+  }
+
+  // <instances_num> and then every instance in the usual format,
+  // answers to each instance are printed on a separate line
+  void answer_batch(std::istream &is, std::ostream &os, const Options &options) {
+    std::size_t instances_num = 0;
+    is >> instances_num;
+    std::vector<yLAB::Instance<wide_type>> instances(instances_num);
+    for (auto &&[array, queries] : instances) {
+      std::size_t size = 0;
+      is >> size;
+      array.resize(size);
+      for (auto &&value : array) {
+        is >> value;
+      }
+      is >> size;
+      queries.resize(size);
+      for (auto &&[l, r] : queries) {
+        is >> l >> r;
+      }
+    }
+
+    yLAB::BatchSolver<wide_type> solver {options.threads_num, options.block_sz};
+    for (auto &&answers : solver.solve(instances)) {
+      for (auto &&answer : answers) {
+        os << answer << ' ';
+      }
+      os << '\n';
+    }
+    os << std::flush;
+  }
+
+  // <rows> <cols> a11 a12 ... <queries_num> r1 c1 r2 c2 ..., where (r1, c1)
+  // and (r2, c2) are the opposite corners of the rectangle. The full 2D table
+  // is used if it fits into the memory limit, the tiled one otherwise.
+  void answer_matrix(std::istream &is, std::ostream &os, const Options &options) {
+    using full_type  = yLAB::SparseTable2D<wide_type, allocator_type<wide_type>>;
+    using block_type = yLAB::BlockRmq2D<wide_type, allocator_type<wide_type>>;
+
+    std::size_t rows = 0, cols = 0;
+    if (!(is >> rows >> cols)) {
+      throw std::runtime_error {"invalid size of the matrix"};
+    }
+    if (cols && rows > std::numeric_limits<std::size_t>::max() / cols) {
+      throw std::runtime_error {"the matrix is too big"};
+    }
+    std::vector<wide_type> matrix(rows * cols);
+    for (auto &&value : matrix) {
+      if (!(is >> value)) {
+        throw std::runtime_error {"the matrix is cut off or has an invalid value"};
+      }
+    }
+    std::size_t queries_num = 0;
+    if (!(is >> queries_num)) {
+      throw std::runtime_error {"invalid number of queries"};
+    }
+    std::vector<yLAB::rectangle_query_type> queries(queries_num);
+    for (std::size_t id = 0; auto &&[rows_range, cols_range] : queries) {
+      if (!(is >> rows_range.first >> cols_range.first >>
+                  rows_range.second >> cols_range.second)) {
+        throw std::runtime_error {"the queries are cut off or have an invalid corner"};
+      }
+      if (std::max(rows_range.first, rows_range.second) >= rows ||
+          std::max(cols_range.first, cols_range.second) >= cols) {
+        throw std::out_of_range {"query " + std::to_string(id) + " is out of the " +
+                                 std::to_string(rows) + "x" + std::to_string(cols) +
+                                 " matrix"};
+      }
+      ++id;
+    }
+
+    auto answer = [&](auto &&engine, std::string_view name) {
+      if (options.memory_report) {
+        std::cerr << "engine: " << name << '\n' << engine.memory_usage();
+      }
+      for (auto &&answer : yLAB::ans_queries(engine, queries, options.threads_num)) {
+        os << answer << ' ';
+      }
+      os << std::endl;
+    };
+    allocator_type<wide_type> alloc {options.pages, options.numa};
+    auto full_mem = full_type::estimate_memory(rows, cols).total() +
+                    matrix.size() * sizeof(wide_type);
+    if (full_mem <= options.memory_limit) {
+      answer(full_type(matrix.begin(), matrix.end(), cols, alloc), "2d sparse table");
+    } else {
+      answer(block_type(matrix.begin(), matrix.end(), cols,
+                        block_type::default_tile_size, alloc), "2d blocks");
+    }
+  }
+
+  // the usual text input to the binary one
+  void encode_input(std::istream &is, std::ostream &os) {
+    namespace codec = yLAB::codec;
+
+    yLAB::NumberReader reader {is};
+    codec::Writer writer {os};
+    auto size = reader.read<std::size_t>();
+    writer.varint(size);
+    std::array<std::int64_t, codec::block_size> block;
+    std::int64_t prev = 0;
+    for (std::size_t first = 0; first < size; first += codec::block_size) {
+      auto count = std::min(codec::block_size, size - first);
+      for (std::size_t id = 0; id < count; ++id) {
+        block[id] = reader.read<std::int64_t>();
+      }
+      writer.block(block.data(), count, &prev);
+    }
+
+    auto queries_num = reader.read<std::size_t>();
+    writer.varint(queries_num);
+    std::vector<yLAB::range_query_type> queries;
+    prev = 0;
+    for (std::size_t first = 0; first < queries_num; first += queries.size()) {
+      queries.resize(std::min(yLAB::QueryPipeline::chunk_size, queries_num - first));
+      for (auto &&[l, r] : queries) {
+        l = reader.read<std::size_t>(), r = reader.read<std::size_t>();
+      }
+      codec::write_queries(writer, queries, prev);
+    }
+  }
+
+  // binary answers to the text ones
+  void decode_answers(std::istream &is, std::ostream &os) {
+    yLAB::codec::Reader reader {is};
+    for (auto &&answer : yLAB::codec::read_answers(reader)) {
+      os << answer << ' ';
+    }
+    os << std::endl;
   }
 
 } // <--- namespace
 
-int main() {
-  auto [array, queries] = get_data(std::cin);
-  yLAB::RmqSolver rmq(array.begin(), array.end());
+int main(int argc, char **argv) try {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
 
-  for (std::size_t i = 0, size = queries.size(); i < size; i += 2) {
-    std::cout << rmq.ans_query({queries[i], queries[i + 1]}) << ' ';
+  auto options = get_options(argc, argv);
+  if (options.batch) {
+    answer_batch(std::cin, std::cout, options);
+    return 0;
+  }
+  if (options.matrix) {
+    answer_matrix(std::cin, std::cout, options);
+    return 0;
+  }
+  if (!options.connect.empty()) {
+    ask_server(std::cin, std::cout, options);
+    return 0;
+  }
+  if (options.encode) {
+    encode_input(std::cin, std::cout);
+    return 0;
+  }
+  if (options.decode) {
+    decode_answers(std::cin, std::cout);
+    return 0;
+  }
+  // the readers of both formats, only one of them is used
+  std::optional<yLAB::NumberReader> text_reader;
+  std::optional<yLAB::codec::Reader> binary_reader;
+  std::optional<yLAB::codec::QueryReader> binary_queries;
+  std::variant<std::vector<narrow_type>, std::vector<wide_type>> array;
+  yLAB::QueryPipeline::source_type queries;
+  if (options.input == yLAB::DataFormat::binary) {
+    binary_reader.emplace(std::cin);
+    auto size = binary_reader->varint();
+    yLAB::codec::ValueReader values {*binary_reader, size};
+    array = get_array(size, [&](wide_type &value) { return values.read(value); });
+    binary_queries.emplace(*binary_reader);
+    queries = yLAB::QueryPipeline::binary_queries(*binary_queries);
+  } else {
+    text_reader.emplace(std::cin);
+    std::size_t size = 0;
+    text_reader->read(size);
+    array = get_array(size, [&](wide_type &value) { return text_reader->read(value); });
+    queries = yLAB::QueryPipeline::text_queries(*text_reader);
   }
-  std::cout << std::endl;
-}
 
+  std::visit([&](auto &&array) {
+    if (!options.socket.empty()) {
+      auto array_size = array.size();
+      with_engine(std::move(array), options, [&](auto &&engine, std::string_view name) {
+        report(engine, name, options);
+        yLAB::QueryServer server {engine, array_size, options.threads_num};
+        server.listen(options.socket);
+      });
+      return;
+    }
+    // the queries are read while the engine is being built
+    yLAB::QueryPipeline pipeline {std::move(queries), std::cout, options.output,
+                                  options.threads_num, options.order, options.dedup};
+    with_engine(std::move(array), options, [&](auto &&engine, std::string_view name) {
+      pipeline.answer(engine);
+      // the report follows the queries to show what a lazy engine has built
+      report(engine, name, options);
+    });
+    if (options.dedup) {
+      auto queries_num  = pipeline.queries_number();
+      auto distinct_num = pipeline.distinct_number();
+      std::cerr << "dedup: " << queries_num << " queries, " << distinct_num
+                << " distinct, ratio "
+                << (distinct_num ? static_cast<double>(queries_num) / distinct_num : 1.0)
+                << '\n';
+    }
+  }, array);
+} catch (const std::exception &error) {
+  std::cerr << "error: " << error.what() << '\n';
+  return 1;
+}
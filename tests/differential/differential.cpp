@@ -0,0 +1,352 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <mutex>
+#include <limits>
+#include <utility>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+#include "rmq.hpp"
+#include "sparse_table.hpp"
+#include "disjoint_sparse_table.hpp"
+#include "query_scheduler.hpp"
+#include "top_k.hpp"
+#include "parallel.hpp"
+
+/*
+ * Differential testing of the engines: all of them answer the same random
+ * and adversarial tests (n = 1, equal values, sorted and extreme values,
+ * sizes around the thresholds of RmqSolver, full-range and reversed queries)
+ * and must agree with the sparse table, which is checked by a naive scan.
+ * Tests run in parallel. Then every engine is timed on one big random test:
+ *   ./differential [--seed=<n>] [--cases=<n>] [--max-size=<n>] [--threads=<n>]
+ *                  [--bench-size=<n>] [--bench-queries=<n>] [--max-ratio=<r>]
+ * With --max-ratio the run fails if the queries of an engine take more than
+ * r times those of the sparse table, so it gates the speed of new engines.
+ * A new engine is one more make_engine() line in engines().
+*/
+
+namespace {
+
+  using size_type  = std::size_t;
+  using value_type = std::int64_t;
+  using query_type = yLAB::range_query_type;
+  using array_type = std::vector<value_type>;
+  using clock_type = std::chrono::steady_clock;
+  using queries_type = std::vector<query_type>;
+
+  double seconds_since(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+  }
+
+  struct Min final {
+    value_type operator()(value_type lhs, value_type rhs) const { return std::min(lhs, rhs); }
+  };
+
+  struct Timing final {
+    double build = 0;
+    double query = 0;
+  };
+
+  // builds the engine over the array and answers the queries with it
+  struct Engine final {
+    std::string_view name;
+    std::function<array_type(const array_type&, const queries_type&, Timing&)> run;
+  };
+
+  template <typename Build>
+  Engine make_engine(std::string_view name, Build build,
+                     yLAB::QueryOrder order = yLAB::QueryOrder::input) {
+    return {name, [build, order](const array_type &array, const queries_type &queries,
+                                 Timing &timing) {
+      auto start = clock_type::now();
+      auto engine = build(array);
+      timing.build = seconds_since(start);
+      start = clock_type::now();
+      auto answers = yLAB::ans_queries(engine, queries, order, 1);
+      timing.query = seconds_since(start);
+      return array_type(answers.begin(), answers.end());
+    }};
+  }
+
+  template <template <typename> class BlockLevel>
+  using solver_type = yLAB::RmqSolver<value_type, std::allocator<value_type>, BlockLevel>;
+
+  // the blocks of RmqSolver are forced with an explicit block size
+  template <template <typename> class BlockLevel>
+  solver_type<BlockLevel> blocks(const array_type &array) {
+    return {array.begin(), array.end(),
+            solver_type<BlockLevel>::choose_block_size(array.size())};
+  }
+
+  // the first engine is the reference for the others
+  std::vector<Engine> engines() {
+    return {
+      make_engine("sparse table", [](const array_type &array) {
+        return yLAB::SparseTable(array.begin(), array.end(), array.size());
+      }),
+      make_engine("disjoint sparse table", [](const array_type &array) {
+        return yLAB::DisjointSparseTable<value_type, Min>(array.begin(), array.end());
+      }),
+      make_engine("rmq", [](const array_type &array) {
+        return yLAB::RmqSolver(array.begin(), array.end());
+      }),
+      make_engine("rmq blocks", blocks<yLAB::BlockSparseTable>),
+      make_engine("rmq superblocks", blocks<yLAB::SuperblockTable>),
+      make_engine("rmq lazy", blocks<yLAB::LazyBlockSparseTable>),
+      make_engine("rmq hilbert order", blocks<yLAB::BlockSparseTable>,
+                  yLAB::QueryOrder::hilbert),
+      make_engine("top-k", [](const array_type &array) {
+        return yLAB::RangeTopK(array.begin(), array.end());
+      }),
+    };
+  }
+
+  // O(r - l) per query, checks the reference
+  value_type naive_min(const array_type &array, query_type query) {
+    auto [l, r] = std::minmax(query.first, query.second);
+    return *std::min_element(array.begin() + l, array.begin() + r + 1);
+  }
+
+  struct Case final {
+    std::string name;
+    array_type array;
+    queries_type queries;
+  };
+
+  enum class Layout { random, few_values, equal, increasing, decreasing, sawtooth,
+                      valley, extremes };
+
+  constexpr std::pair<Layout, std::string_view> layouts[] {
+    {Layout::random, "random"}, {Layout::few_values, "few values"},
+    {Layout::equal, "equal"}, {Layout::increasing, "increasing"},
+    {Layout::decreasing, "decreasing"}, {Layout::sawtooth, "sawtooth"},
+    {Layout::valley, "valley"}, {Layout::extremes, "extremes"},
+  };
+
+  array_type make_array(Layout layout, size_type size, std::mt19937_64 &engine) {
+    constexpr auto min = std::numeric_limits<value_type>::min();
+    constexpr auto max = std::numeric_limits<value_type>::max();
+
+    array_type array(size);
+    for (size_type id = 0; id < size; ++id) {
+      auto value = static_cast<value_type>(id);
+      switch (layout) {
+        case Layout::random:     array[id] = static_cast<value_type>(engine()); break;
+        case Layout::few_values: array[id] = static_cast<value_type>(engine() % 3); break;
+        case Layout::equal:      array[id] = 42; break;
+        case Layout::increasing: array[id] = value; break;
+        case Layout::decreasing: array[id] = -value; break;
+        case Layout::sawtooth:   array[id] = value % 7; break;
+        case Layout::valley:     array[id] = std::abs(value - static_cast<value_type>(size / 2));
+                                 break;
+        case Layout::extremes:   array[id] = (engine() % 2 ? min : max) - (engine() % 2);
+                                 break;
+      }
+    }
+    return array;
+  }
+
+  // all the pairs for small arrays; otherwise the full range, points,
+  // reversed borders, prefixes, suffixes, the longest ranges and random ones
+  queries_type make_queries(size_type size, std::mt19937_64 &engine) {
+    constexpr size_type all_pairs_size = 64;
+    constexpr size_type max_queries    = 20000;
+
+    queries_type queries;
+    if (size <= all_pairs_size) {
+      for (size_type l = 0; l < size; ++l) {
+        for (size_type r = 0; r < size; ++r) {
+          queries.emplace_back(l, r);
+        }
+      }
+      return queries;
+    }
+    auto any = [&] { return static_cast<size_type>(engine() % size); };
+    queries.emplace_back(0, size - 1);
+    queries.emplace_back(size - 1, 0);
+    queries.emplace_back(1, size - 1);
+    queries.emplace_back(0, size - 2);
+    auto queries_num = std::min(max_queries, 4 * size);
+    while (queries.size() < queries_num) {
+      auto point = any();
+      switch (engine() % 6) {
+        case 0: queries.emplace_back(point, point); break;
+        case 1: queries.emplace_back(0, point); break;
+        case 2: queries.emplace_back(point, size - 1); break;
+        case 3: queries.emplace_back(point, std::min(size - 1, point + engine() % 64)); break;
+        default: queries.emplace_back(point, any()); break;
+      }
+    }
+    return queries;
+  }
+
+  // the fixed adversarial cases and cases_num random ones
+  std::vector<Case> make_cases(size_type cases_num, size_type max_size, std::uint64_t seed) {
+    using solver = yLAB::RmqSolver<value_type>;
+
+    std::vector<size_type> sizes {1, 2, 3, 4, 31, 32, 33, 255, 256, 257,
+                                  solver::scan_size, solver::scan_size + 1,
+                                  solver::sparse_size, solver::sparse_size + 1, max_size};
+    std::mt19937_64 engine {seed};
+    for (size_type id = 0; id < cases_num; ++id) {
+      sizes.push_back(1 + engine() % max_size);
+    }
+    std::vector<Case> cases;
+    for (auto size : sizes) {
+      for (auto [layout, layout_name] : layouts) {
+        Case test {std::string(layout_name) + " n=" + std::to_string(size), {}, {}};
+        test.array   = make_array(layout, size, engine);
+        test.queries = make_queries(size, engine);
+        cases.push_back(std::move(test));
+      }
+    }
+    return cases;
+  }
+
+  struct Mismatch final {
+    std::string engine;
+    std::string test;
+    query_type query;
+    value_type expected;
+    value_type got;
+  };
+
+  // Runs every engine on every case in parallel. The reference is checked by
+  // the naive scan on up to check_queries queries of every case.
+  std::vector<Mismatch> run_cases(const std::vector<Engine> &engines,
+                                  const std::vector<Case> &cases, size_type threads_num) {
+    constexpr size_type max_reported  = 20;
+    constexpr size_type check_queries = 2000;
+
+    std::vector<Mismatch> mismatches;
+    std::mutex mutex;
+    auto report = [&](Mismatch mismatch) {
+      std::lock_guard lock {mutex};
+      if (mismatches.size() < max_reported) {
+        mismatches.push_back(std::move(mismatch));
+      }
+    };
+    yLAB::parallel_for(cases.size(), threads_num, [&](size_type, size_type id) {
+      auto &&[name, array, queries] = cases[id];
+      Timing timing;
+      auto expected = engines.front().run(array, queries, timing);
+      auto step = std::max<size_type>(1, queries.size() / check_queries);
+      for (size_type query_id = 0; query_id < queries.size(); query_id += step) {
+        auto naive = naive_min(array, queries[query_id]);
+        if (expected[query_id] != naive) {
+          report({std::string(engines.front().name), name, queries[query_id],
+                  naive, expected[query_id]});
+        }
+      }
+      for (auto engine = engines.begin() + 1; engine != engines.end(); ++engine) {
+        auto answers = engine->run(array, queries, timing);
+        auto mismatch = std::mismatch(answers.begin(), answers.end(), expected.begin());
+        if (mismatch.first != answers.end()) {
+          auto query_id = mismatch.first - answers.begin();
+          report({std::string(engine->name), name, queries[query_id],
+                  *mismatch.second, *mismatch.first});
+        }
+      }
+    });
+    return mismatches;
+  }
+
+  struct Options final {
+    std::uint64_t seed = std::random_device{}();
+    size_type cases_num = 20;
+    size_type max_size = 100000;
+    size_type threads_num = yLAB::default_threads_number();
+    size_type bench_size = 1000000;
+    size_type bench_queries = 1000000;
+    double max_ratio = 0;
+  };
+
+  Options get_options(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+      std::string_view arg {argv[i]};
+      std::string value {arg.substr(arg.find('=') + 1)};
+      if (arg.starts_with("--seed=")) {
+        options.seed = std::stoull(value);
+      } else if (arg.starts_with("--cases=")) {
+        options.cases_num = std::stoul(value);
+      } else if (arg.starts_with("--max-size=")) {
+        options.max_size = std::max<size_type>(1, std::stoul(value));
+      } else if (arg.starts_with("--threads=")) {
+        options.threads_num = std::stoul(value);
+      } else if (arg.starts_with("--bench-size=")) {
+        options.bench_size = std::stoul(value);
+      } else if (arg.starts_with("--bench-queries=")) {
+        options.bench_queries = std::stoul(value);
+      } else if (arg.starts_with("--max-ratio=")) {
+        options.max_ratio = std::stod(value);
+      } else {
+        throw std::invalid_argument {"unknown option: " + std::string(arg)};
+      }
+    }
+    return options;
+  }
+
+  // Times every engine on a random array and random queries, one thread.
+  // False if an engine is more than max_ratio times slower than the first one.
+  bool run_bench(const std::vector<Engine> &engines, const Options &options) {
+    std::mt19937_64 engine {options.seed};
+    auto array = make_array(Layout::random, options.bench_size, engine);
+    queries_type queries(options.bench_queries);
+    for (auto &&[l, r] : queries) {
+      l = engine() % array.size(), r = engine() % array.size();
+    }
+
+    std::cout << "bench: n=" << array.size() << ", " << queries.size() << " queries\n";
+    bool passed = true;
+    double reference = 0;
+    for (auto &&[name, run] : engines) {
+      Timing timing;
+      run(array, queries, timing);
+      auto query_ns = timing.query * 1e9 / std::max<size_type>(1, queries.size());
+      if (reference == 0) { reference = query_ns; }
+      auto ratio = (reference > 0 ? query_ns / reference : 1.0);
+      bool slow = options.max_ratio > 0 && ratio > options.max_ratio;
+      passed = passed && !slow;
+      std::cout << std::left << std::setw(24) << name
+                << " build " << std::setw(10) << timing.build << " s"
+                << "  query " << std::setw(8) << query_ns << " ns"
+                << "  x" << std::setw(6) << ratio << (slow ? "  too slow" : "") << '\n';
+    }
+    return passed;
+  }
+
+} // <--- namespace
+
+int main(int argc, char **argv) {
+  auto options = get_options(argc, argv);
+  std::cout << "seed " << options.seed << std::endl;
+
+  auto all_engines = engines();
+  auto cases = make_cases(options.cases_num, options.max_size, options.seed);
+  auto start = clock_type::now();
+  auto mismatches = run_cases(all_engines, cases, options.threads_num);
+  std::cout << cases.size() << " tests, " << all_engines.size() << " engines: "
+            << seconds_since(start) << " s" << std::endl;
+  for (auto &&[engine, test, query, expected, got] : mismatches) {
+    std::cout << engine << " on " << test << ", query [" << query.first << ", "
+              << query.second << "]: expected " << expected << ", got " << got << '\n';
+  }
+
+  bool passed = mismatches.empty();
+  if (options.bench_size && options.bench_queries) {
+    passed = run_bench(all_engines, options) && passed;
+  }
+  std::cout << (passed ? "passed" : "not passed") << std::endl;
+  return passed ? 0 : 1;
+}
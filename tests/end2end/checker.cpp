@@ -1,45 +1,129 @@
 #include <iostream>
 #include <vector>
-#include <fstream>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
 
 #include "rmq.hpp"
+#include "parallel.hpp"
+#include "number_reader.hpp"
 
 namespace {
 
-  bool compare_answers(std::ifstream &test_file, std::ifstream &ans_file) { 
-    std::vector<int64_t> array;
-    std::vector<int64_t> queries;
-    std::vector<int64_t> data;
-    
-    std::copy(std::istream_iterator<int64_t>(test_file), std::istream_iterator<int64_t>(),
-              std::back_inserter(data));
-    
-    auto begin = data.begin();
-    std::copy_n(std::next(begin), *begin, std::back_inserter(array));
-    std::advance(begin, *begin + 1);
-    std::copy_n(std::next(begin), *begin * 2, std::back_inserter(queries));
- 
+  using size_type  = std::size_t;
+  using value_type = int64_t;
+  using query_type = std::pair<size_type, size_type>;
+  using yLAB::NumberReader;
+
+  struct Mismatch final {
+    size_type id;
+    query_type query;
+    value_type expected;
+    value_type got;
+  };
+
+  struct Report final {
+    static constexpr size_type max_reported = 10;
+
+    size_type mismatches_number = 0;
+    std::vector<Mismatch> mismatches;
+    bool missing_answers = false;
+    bool extra_answers   = false;
+
+    bool passed() const noexcept {
+      return mismatches_number == 0 && !missing_answers && !extra_answers;
+    }
+  };
+
+  // Queries and answers are read batch by batch, and every batch is
+  // checked in parallel chunks.
+  Report compare_answers(NumberReader &test_file, NumberReader &ans_file) {
+    constexpr size_type batch_size = 1 << 20;
+    constexpr size_type chunk_size = 1 << 14;
+
+    std::vector<value_type> array(test_file.read<size_type>());
+    for (auto &&value : array) {
+      value = test_file.read<value_type>();
+    }
     yLAB::RmqSolver rmq(array.begin(), array.end());
-    int64_t answer = 0;
-    for (std::size_t i = 0, size = queries.size(); i < size; i += 2) {
-      ans_file >> answer;
-      if (answer != rmq.ans_query({queries[i], queries[i + 1]})) {
-        return false;
+    std::vector<value_type>().swap(array);
+
+    Report report;
+    auto queries_number = test_file.read<size_type>();
+    std::vector<query_type> queries;
+    std::vector<value_type> answers;
+    std::vector<std::vector<Mismatch>> chunks_mismatches;
+    for (size_type first = 0; first < queries_number; first += batch_size) {
+      queries.resize(std::min(batch_size, queries_number - first));
+      answers.resize(queries.size());
+      for (size_type id = 0; id < queries.size(); ++id) {
+        queries[id].first  = test_file.read<size_type>();
+        queries[id].second = test_file.read<size_type>();
+        if (!ans_file.read(answers[id])) {
+          // the answers read so far are still checked
+          report.missing_answers = true;
+          queries.resize(id);
+          break;
+        }
       }
+
+      auto chunks_number = (queries.size() + chunk_size - 1) / chunk_size;
+      chunks_mismatches.assign(chunks_number, {});
+      yLAB::parallel_for(chunks_number, yLAB::default_threads_number(),
+                         [&](size_type, size_type chunk) {
+        auto end = std::min(queries.size(), (chunk + 1) * chunk_size);
+        for (auto id = chunk * chunk_size; id < end; ++id) {
+          auto expected = rmq.ans_query(queries[id]);
+          if (expected != answers[id]) {
+            chunks_mismatches[chunk].push_back({first + id, queries[id], expected, answers[id]});
+          }
+        }
+      });
+      for (auto &&chunk : chunks_mismatches) {
+        report.mismatches_number += chunk.size();
+        for (auto &&mismatch : chunk) {
+          if (report.mismatches.size() == Report::max_reported) { break; }
+          report.mismatches.push_back(mismatch);
+        }
+      }
+      if (report.missing_answers) { break; }
     }
-    return true;
+    value_type extra;
+    report.extra_answers = !report.missing_answers && ans_file.read(extra);
+    return report;
   }
 
 } // <--- namespace
 
 int main(int argc, char **argv) {
-  std::ifstream test_file {argv[1]};
-  std::ifstream ans_file {argv[2]};
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <test> <answers>" << std::endl;
+    return 1;
+  }
+  NumberReader test_file {argv[1]};
+  NumberReader ans_file {argv[2]};
 
-  if (compare_answers(test_file, ans_file)) {
+  auto report = compare_answers(test_file, ans_file);
+  if (report.passed()) {
     std::cout << "passed" << std::endl;
-  } else {
-    std::cout << "not passed" << std::endl;
+    return 0;
+  }
+  std::cout << "not passed" << std::endl;
+  for (auto &&[id, query, expected, got] : report.mismatches) {
+    std::cout << "query " << id << " [" << query.first << ", " << query.second
+              << "]: expected " << expected << ", got " << got << '\n';
   }
+  if (report.mismatches_number > report.mismatches.size()) {
+    std::cout << "... " << report.mismatches_number << " mismatches in total\n";
+  }
+  if (report.missing_answers) {
+    std::cout << "the answers file has less answers than queries\n";
+  }
+  if (report.extra_answers) {
+    std::cout << "the answers file has more answers than queries\n";
+  }
+  return 1;
 }
-
@@ -8,8 +8,13 @@
 #include <utility>
 #include <string>
 #include <string_view>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <numeric>
+#include <ranges>
 
-#include "sparse_table.hpp"
+#include "parallel.hpp"
 
 namespace testing {
 
@@ -23,22 +28,47 @@ namespace dirs {
   constexpr std::string_view ans_dir      = "../tests/end2end/resources/answers/";
 }
 
+// how array values are laid out
+enum class Shape { random, sorted, reverse_sorted, duplicates, sawtooth };
+// lengths of queries
+enum class QueriesSkew { uniform, short_queries, long_queries };
+
+/*
+ * Everything is generated in chunks, each one with its own engine seeded
+ * from (seed, test number, stream, chunk number), so the output depends
+ * only on the seed and not on the number of threads.
+*/
+
 template<std::integral T>
 class generator final {
   using size_type         = std::size_t;
   using value_type        = T;
-  using generator_type    = std::mt19937;
-  using distribution_type = std::uniform_int_distribution<T>;
-
-  static constexpr int MIN_VALUE                = 0;
-  static constexpr int MAX_VALUE                = 100000000;
+  using generator_type    = std::mt19937_64;
+  using query_type        = std::pair<size_type, size_type>;
+ public:
+  static constexpr value_type MIN_VALUE             = 0;
+  static constexpr value_type MAX_VALUE             = 100000000;
   static constexpr size_type DEFAULT_SIZE           = 100000;
   static constexpr size_type DEFAULT_QUERIES_NUMBER = 1000;
+ private:
+  static constexpr size_type CHUNK_SIZE          = 1 << 16;
+  static constexpr size_type DUPLICATES_NUMBER   = 16;
+  static constexpr size_type SHORT_QUERY_LENGTH  = 32;
+  // streams of engines
+  enum Stream : std::uint32_t { ARRAY, QUERIES, SHAPE };
+
+  generator_type engine(size_type test_number, Stream stream, size_type chunk) const {
+    std::seed_seq seq {seed_ & 0xffffffff, seed_ >> 32,
+                       static_cast<std::uint64_t>(test_number),
+                       static_cast<std::uint64_t>(stream),
+                       static_cast<std::uint64_t>(chunk)};
+    return generator_type {seq};
+  }
 
   template <std::integral U>
-  U random_value(U min_val, U max_val) {
-    distribution_type distr(min_val, max_val);
-    return distr(generator_);
+  static U random_value(generator_type &engine, U min_val, U max_val) {
+    std::uniform_int_distribution<U> distr(min_val, max_val);
+    return distr(engine);
   }
 
   void create_source_directory() {
@@ -62,6 +92,151 @@ class generator final {
     }
   }
 
+  // calls func(engine, begin, end) for every chunk of [0, size) in parallel
+  template <typename Func>
+  void for_each_chunk(size_type size, size_type test_number, Stream stream,
+                      Func func) const {
+    auto chunks_num = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    yLAB::parallel_for(chunks_num, threads_num_, [&](size_type, size_type chunk) {
+      auto chunk_engine = engine(test_number, stream, chunk);
+      func(chunk_engine, chunk * CHUNK_SIZE, std::min(size, (chunk + 1) * CHUNK_SIZE));
+    });
+  }
+
+  std::vector<value_type> generate_array(size_type test_number) const {
+    std::vector<value_type> array(array_size_);
+    // sorted shapes are linear functions of the index, so every chunk can
+    // compute its part independently
+    auto range = static_cast<long double>(max_value_) - min_value_;
+    auto linear = [&](size_type id, size_type period) {
+      return static_cast<value_type>(min_value_ + range * id / period);
+    };
+    auto shape_engine = engine(test_number, SHAPE, 0);
+    std::vector<value_type> duplicates(DUPLICATES_NUMBER);
+    for (auto &&value : duplicates) {
+      value = random_value(shape_engine, min_value_, max_value_);
+    }
+    auto period = random_value<size_type>(shape_engine, 2, 1024);
+
+    for_each_chunk(array_size_, test_number, ARRAY,
+                   [&](auto &chunk_engine, size_type begin, size_type end) {
+      for (auto id = begin; id < end; ++id) {
+        switch (shape_) {
+          case Shape::random:
+            array[id] = random_value(chunk_engine, min_value_, max_value_);
+            break;
+          case Shape::sorted:
+            array[id] = linear(id, array_size_);
+            break;
+          case Shape::reverse_sorted:
+            array[id] = linear(array_size_ - 1 - id, array_size_);
+            break;
+          case Shape::duplicates:
+            array[id] = duplicates[random_value<size_type>(chunk_engine, 0,
+                                                          DUPLICATES_NUMBER - 1)];
+            break;
+          case Shape::sawtooth:
+            array[id] = linear(id % period, period);
+            break;
+        }
+      }
+    });
+    return array;
+  }
+
+  std::vector<query_type> generate_queries(size_type test_number) const {
+    std::vector<query_type> queries(queries_num_);
+    auto size = array_size_;
+    for_each_chunk(queries_num_, test_number, QUERIES,
+                   [&](auto &chunk_engine, size_type begin, size_type end) {
+      for (auto id = begin; id < end; ++id) {
+        size_type length = 0;
+        switch (skew_) {
+          case QueriesSkew::uniform: {
+            auto l = random_value<size_type>(chunk_engine, 0, size - 1);
+            queries[id] = {l, random_value(chunk_engine, l, size - 1)};
+            continue;
+          }
+          case QueriesSkew::short_queries:
+            length = random_value<size_type>(chunk_engine, 1,
+                                             std::min(size, SHORT_QUERY_LENGTH));
+            break;
+          case QueriesSkew::long_queries:
+            length = random_value<size_type>(chunk_engine, (size + 1) / 2, size);
+            break;
+        }
+        auto l = random_value<size_type>(chunk_engine, 0, size - length);
+        queries[id] = {l, l + length - 1};
+      }
+    });
+    return queries;
+  }
+
+  // Offline answers in O((n + q) log n) time and O(n + q) memory: queries
+  // are bucketed by the right end, and while the array is swept, the stack
+  // keeps the positions of the suffix minima of the prefix.
+  std::vector<value_type> compute_answers(const std::vector<value_type> &array,
+                                          const std::vector<query_type> &queries) const {
+    std::vector<size_type> bucket_begin(array.size() + 1, 0);
+    for (auto &&query : queries) {
+      ++bucket_begin[query.second + 1];
+    }
+    std::partial_sum(bucket_begin.begin(), bucket_begin.end(), bucket_begin.begin());
+    std::vector<size_type> bucket(queries.size());
+    auto next = bucket_begin;
+    for (size_type id = 0; id < queries.size(); ++id) {
+      bucket[next[queries[id].second]++] = id;
+    }
+
+    std::vector<value_type> answers(queries.size());
+    std::vector<size_type> stack;
+    for (size_type r = 0; r < array.size(); ++r) {
+      while (!stack.empty() && array[stack.back()] >= array[r]) {
+        stack.pop_back();
+      }
+      stack.push_back(r);
+      for (auto id = bucket_begin[r]; id < bucket_begin[r + 1]; ++id) {
+        auto min_pos = std::lower_bound(stack.begin(), stack.end(), queries[bucket[id]].first);
+        answers[bucket[id]] = array[*min_pos];
+      }
+    }
+    return answers;
+  }
+
+  // numbers are formatted in parallel chunks and written in order, a few
+  // chunks per thread at a time, so the buffers are reused
+  template <std::ranges::random_access_range Range, typename Format>
+  void write(std::ofstream &os, const Range &range, Format format) const {
+    static constexpr size_type max_number_length = 2 * 24;
+
+    auto size       = std::ranges::size(range);
+    auto chunks_num = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::string> buffers(std::min(chunks_num, 4 * threads_num_));
+    for (size_type first = 0; first < chunks_num; first += buffers.size()) {
+      auto round_size = std::min(buffers.size(), chunks_num - first);
+      yLAB::parallel_for(round_size, threads_num_, [&](size_type, size_type id) {
+        auto begin = (first + id) * CHUNK_SIZE;
+        auto end   = std::min(size, begin + CHUNK_SIZE);
+        auto &buffer = buffers[id];
+        buffer.resize((end - begin) * max_number_length);
+        auto out = buffer.data();
+        for (auto pos = begin; pos < end; ++pos) {
+          out = format(out, range[pos]);
+        }
+        buffer.resize(out - buffer.data());
+      });
+      for (size_type id = 0; id < round_size; ++id) {
+        os.write(buffers[id].data(), buffers[id].size());
+      }
+    }
+  }
+
+  static char *write_number(char *out, std::integral auto number) {
+    out = std::to_chars(out, out + 24, number).ptr;
+    *out++ = ' ';
+    return out;
+  }
+
   void generate_array_and_queries(size_type test_number) {
     std::string test_name = "test" + std::to_string(test_number) + ".txt";
     std::string ans_name  = "answer" + std::to_string(test_number) + ".txt";
@@ -70,41 +245,36 @@ class generator final {
 
     // generating array
     array_size_ = (array_size_ == 0 ? 1 : array_size_);
-    std::vector<int> array(array_size_);
-    std::generate(array.begin(), array.end(), [&] { return random_value(min_value_, max_value_); });
+    auto array = generate_array(test_number);
     test_file << array_size_ << ' ';
-    std::copy(array.begin(), array.end(), std::ostream_iterator<int>(test_file, " "));
+    write(test_file, array, [](char *out, value_type value) {
+      return write_number(out, value);
+    });
     // generating queries
-    std::vector<std::pair<size_type, size_type>> queries(queries_num_);
-    std::generate(queries.begin(), queries.end(), [&, size = array.size()] {
-                       auto l = random_value(0ul, size - 1);
-                       auto r = random_value(l, size - 1);
-                       return std::make_pair(l, r);
-                  });
+    auto queries = generate_queries(test_number);
     test_file << queries.size() << ' ';
-    for (auto &&[l, r] : queries) {
-      test_file << l << ' ' << r << ' ';
-    }
-    // generating answers with sparse table
-    yLAB::SparseTable<int> sparse_table(array.begin(), array.end(), array.size());
-    std::transform(queries.begin(), queries.end(), std::ostream_iterator<int>(ans_file, " "),
-                  [&sparse_table](auto &&pair) {
-      return  sparse_table.min({pair.first, pair.second});
+    write(test_file, queries, [](char *out, const query_type &query) {
+      return write_number(write_number(out, query.first), query.second);
+    });
+    // generating answers
+    write(ans_file, compute_answers(array, queries), [](char *out, value_type value) {
+      return write_number(out, value);
     });
   }
 
  public:
-  generator(size_type tests_number)
-      : tests_number_ {tests_number} {
-    generator_.seed(static_cast<size_type>(std::time(nullptr)));
-  }
+  generator(size_type tests_number, std::uint64_t seed,
+            size_type threads_num = yLAB::default_threads_number())
+      : tests_number_ {tests_number}, seed_ {seed}, threads_num_ {threads_num} {}
 
-  void generate_tests(int min = MIN_VALUE, int max = MAX_VALUE,
+  void generate_tests(value_type min = MIN_VALUE, value_type max = MAX_VALUE,
                       size_type arr_sz = DEFAULT_SIZE,
-                      size_type queries = DEFAULT_QUERIES_NUMBER) {
+                      size_type queries = DEFAULT_QUERIES_NUMBER,
+                      Shape shape = Shape::random,
+                      QueriesSkew skew = QueriesSkew::uniform) {
     create_source_directory();
     min_value_ = min, max_value_ = max, array_size_ = arr_sz,
-    queries_num_ = queries;
+    queries_num_ = queries, shape_ = shape, skew_ = skew;
     for (size_type counter = 1; counter <= tests_number_; ++counter) {
         generate_array_and_queries(counter);
     }
@@ -112,11 +282,14 @@ class generator final {
 
  private:
   size_type tests_number_;
-  int min_value_;
-  int max_value_;
+  std::uint64_t seed_;
+  size_type threads_num_;
+  value_type min_value_;
+  value_type max_value_;
   size_type array_size_;
   size_type queries_num_;
-  generator_type generator_;
+  Shape shape_;
+  QueriesSkew skew_;
 };
 
 } // <--- namespace testing
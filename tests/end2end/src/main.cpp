@@ -1,34 +1,78 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <random>
+#include <vector>
+#include <cstdint>
 
 #include "end2end.hpp"
 
 namespace ts = testing;
 
-int main(int argc, char* argv[]) {
-  if (argc < 2 || argc > 6) {
-    throw std::runtime_error {"invalid set of arguments, expected 1 - 5, got" +
-                              std::to_string(argc - 1)};
-  }
+namespace {
 
-  auto test_num = std::stoul(argv[1]);
-  ts::generator<int> gen(test_num);
-  if (argc == 2) {
-    gen.generate_tests();
-  } else if (argc == 3) {
-    gen.generate_tests(std::stol(argv[2]));
-  } else if (argc == 4) {
-    gen.generate_tests(std::stol(argv[2]), std::stol(argv[3]));
+struct Options final {
+  std::uint64_t seed = std::random_device{}();
+  ts::Shape shape    = ts::Shape::random;
+  ts::QueriesSkew skew = ts::QueriesSkew::uniform;
+  std::size_t threads_num = yLAB::default_threads_number();
+};
 
-  } else if (argc == 5) {
-    gen.generate_tests(std::stol(argv[2]), std::stol(argv[3]),
-                       std::stoul(argv[4]));
+// options are --name=value and can be mixed with positional arguments
+Options get_options(std::vector<std::string_view> &args) {
+  Options options;
+  std::erase_if(args, [&](std::string_view arg) {
+    if (!arg.starts_with("--")) { return false; }
+
+    auto value = arg.substr(arg.find('=') + 1);
+    if (arg.starts_with("--seed=")) {
+      options.seed = std::stoull(std::string(value));
+    } else if (arg.starts_with("--threads=")) {
+      options.threads_num = std::stoul(std::string(value));
+    } else if (arg == "--shape=random") {
+      options.shape = ts::Shape::random;
+    } else if (arg == "--shape=sorted") {
+      options.shape = ts::Shape::sorted;
+    } else if (arg == "--shape=reverse") {
+      options.shape = ts::Shape::reverse_sorted;
+    } else if (arg == "--shape=duplicates") {
+      options.shape = ts::Shape::duplicates;
+    } else if (arg == "--shape=sawtooth") {
+      options.shape = ts::Shape::sawtooth;
+    } else if (arg == "--queries=uniform") {
+      options.skew = ts::QueriesSkew::uniform;
+    } else if (arg == "--queries=short") {
+      options.skew = ts::QueriesSkew::short_queries;
+    } else if (arg == "--queries=long") {
+      options.skew = ts::QueriesSkew::long_queries;
+    } else {
+      throw std::invalid_argument {"unknown option " + std::string(arg)};
+    }
+    return true;
+  });
+  return options;
+}
 
-  } else if (argc == 6) {
-    gen.generate_tests(std::stol(argv[2]), std::stol(argv[3]),
-                       std::stoul(argv[4]), std::stoul(argv[5]));
+} // <--- namespace
 
+int main(int argc, char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  auto options = get_options(args);
+  if (args.size() < 1 || args.size() > 5) {
+    throw std::runtime_error {"invalid set of arguments, expected 1 - 5, got " +
+                              std::to_string(args.size())};
   }
-}
+  // the seed is printed, so any run can be reproduced
+  std::cout << "seed: " << options.seed << std::endl;
 
+  using generator_type = ts::generator<int>;
+  auto arg = [&](std::size_t id) { return std::string(args[id]); };
+  auto test_num = std::stoul(arg(0));
+  generator_type gen(test_num, options.seed, options.threads_num);
+  auto min     = args.size() > 1 ? std::stoi(arg(1))  : generator_type::MIN_VALUE;
+  auto max     = args.size() > 2 ? std::stoi(arg(2))  : generator_type::MAX_VALUE;
+  auto arr_sz  = args.size() > 3 ? std::stoul(arg(3)) : generator_type::DEFAULT_SIZE;
+  auto queries = args.size() > 4 ? std::stoul(arg(4)) : generator_type::DEFAULT_QUERIES_NUMBER;
+  gen.generate_tests(min, max, arr_sz, queries, options.shape, options.skew);
+}
@@ -16,28 +16,36 @@ exe_main_file_1="./offline_lca"
 checker="./tests/checker"
 
 ##------------------------------------------------------------------------------------------##
+# checkers run concurrently, each one writes its report to its own file
 function run_tests {
-    touch compare_file.txt
+    results_dir=$(mktemp -d)
+    jobs_number=$(nproc)
     npassed_count=0
     echo -e "${white}---end2end testing---${usual}"
     for ((i = 1; i <= ${tests_number}; ++i))
     do
-      tmp_check="${tests_dir}test${i}.txt"
-      ans_file="${answs_dir}answer${i}.txt"
+      while [ $(jobs -rp | wc -l) -ge ${jobs_number} ]
+      do
+        wait -n
+      done
+      ${checker} "${tests_dir}test${i}.txt" "${answs_dir}answer${i}.txt" \
+                 > "${results_dir}/${i}.txt" 2>&1 &
+    done
+    wait
+
+    for ((i = 1; i <= ${tests_number}; ++i))
+    do
+      result="${results_dir}/${i}.txt"
 
       echo -n -e "${purple}Test ${i}: ${usual}\n"
-      ${checker} ${tmp_check} ${ans_file} > compare_file.txt
-      if [ "$(cat compare_file.txt)" == "passed" ]
+      if [ "$(head -n 1 ${result})" == "passed" ]
       then
           echo -e "${green}passed${usual}"
       else
           echo -e "${red}failed${usual}"
+          tail -n +2 ${result}
           npassed_count=$((${npassed_count} + 1))
       fi
-      echo -en "${blue}queries answers:${usual}"
-      printf "\n"
-      cat ${ans_file}
-      printf "\n"
     done
     echo -e "${white}-------------------------------------Total----------------------------------${usual}"
     if [ ${npassed_count} -eq 0 ]
@@ -51,7 +59,7 @@ function run_tests {
       echo -e "${red} \t\t\t\t ${npassed_count} tests failed( ${usual}"
     fi
 
-    rm compare_file.txt
+    rm -r ${results_dir}
 }
 ##------------------------------------------------------------------------------------------##
 
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "batch_solver.hpp"
+#include "sparse_table.hpp"
+
+using namespace yLAB;
+
+TEST(BatchSolver, Batch1) {
+  BatchSolver<int> solver {4};
+  ASSERT_TRUE(solver.solve({}).empty());
+
+  // no threads asked for, one is used
+  BatchSolver<int> single {0};
+  auto answers = single.solve({{{3, 1, 2}, {{0, 2}, {2, 2}}}});
+  ASSERT_EQ(answers, (std::vector<std::vector<int>> {{1, 2}}));
+}
+
+TEST(BatchSolver, Batch2) {
+  static constexpr int InstancesNum = 500;
+
+  std::mt19937 engine {std::random_device{}()};
+  std::uniform_int_distribution<int> value(-1000, 1000);
+  std::vector<Instance<int>> instances(InstancesNum);
+  for (int id = 0; auto &&[array, queries] : instances) {
+    // sizes from tiny ones to ones which don't fit in the arena
+    array.resize(++id % 10 == 0 ? 50000 : id);
+    std::generate(array.begin(), array.end(), [&] { return value(engine); });
+    std::uniform_int_distribution<std::size_t> index(0, array.size() - 1);
+    queries.resize(100);
+    std::generate(queries.begin(), queries.end(), [&] {
+      auto l = index(engine), r = index(engine);
+      return std::make_pair(std::min(l, r), std::max(l, r));
+    });
+  }
+
+  BatchSolver<int> solver {4};
+  auto answers = solver.solve(instances);
+  ASSERT_EQ(answers.size(), instances.size());
+  for (std::size_t id = 0; id < instances.size(); ++id) {
+    auto &&[array, queries] = instances[id];
+    SparseTable sparse(array.begin(), array.end(), array.size());
+    ASSERT_EQ(answers[id].size(), queries.size());
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+      ASSERT_EQ(answers[id][i], sparse.min(queries[i]));
+    }
+  }
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "block_table.hpp"
+
+using namespace yLAB;
+
+TEST(BlockTable, Table1) {
+  for (std::size_t block_sz = 1; block_sz <= 10; ++block_sz) {
+    BlockTable table {block_sz};
+    for (std::size_t type = 0; type < (1ul << (block_sz - 1)); ++type) {
+      // restore the +-1 block by its type
+      std::vector<int> block(block_sz, 0);
+      for (std::size_t i = 1; i < block_sz; ++i) {
+        block[i] = block[i - 1] + ((type >> (i - 1)) & 1 ? 1 : -1);
+      }
+      for (std::size_t l = 0; l < block_sz; ++l) {
+        for (std::size_t r = l; r < block_sz; ++r) {
+          ASSERT_EQ(block[table.min_pos(type, l, r)],
+                    *std::min_element(block.begin() + l, block.begin() + r + 1));
+        }
+      }
+    }
+  }
+}
+
+TEST(BlockTable, Table2) {
+  ASSERT_THROW(BlockTable {0}, std::length_error);
+  ASSERT_THROW(BlockTable {BlockTable::max_block_size}, std::length_error);
+}
+
+TEST(BlockTable, Cache1) {
+  static constexpr int ThreadsNum = 8;
+
+  std::vector<BlockTable::pointer> tables(ThreadsNum);
+  {
+    std::vector<std::jthread> threads;
+    for (auto &&table : tables) {
+      threads.emplace_back([&table] { table = BlockTable::get(9); });
+    }
+  }
+  for (auto &&table : tables) {
+    ASSERT_EQ(table, tables.front());
+  }
+  ASSERT_EQ(BlockTable::get(9), tables.front());
+  ASSERT_NE(BlockTable::get(8), tables.front());
+}
+
+TEST(BlockTable, Lazy1) {
+  for (std::size_t block_sz = 1; block_sz <= 10; ++block_sz) {
+    BlockTable table {block_sz};
+    LazyBlockTable lazy {block_sz};
+    auto types_num = std::size_t{1} << (block_sz - 1);
+    ASSERT_EQ(lazy.memory_usage(), types_num * sizeof(void*));
+    for (std::size_t type = 0; type < types_num; ++type) {
+      for (std::size_t l = 0; l < block_sz; ++l) {
+        for (std::size_t r = l; r < block_sz; ++r) {
+          ASSERT_EQ(lazy.min_pos(type, l, r), table.min_pos(type, l, r));
+        }
+      }
+    }
+    ASSERT_EQ(lazy.memory_usage(), LazyBlockTable::memory(block_sz));
+  }
+  ASSERT_THROW(LazyBlockTable {0}, std::length_error);
+}
+
+TEST(BlockTable, Lazy2) {
+  static constexpr int ThreadsNum = 8;
+  static constexpr std::size_t BlockSize = 8;
+
+  LazyBlockTable lazy {BlockSize};
+  {
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < ThreadsNum; ++i) {
+      threads.emplace_back([&lazy] {
+        for (std::size_t type = 0; type < (1ul << (BlockSize - 1)); ++type) {
+          lazy.min_pos(type, 0, BlockSize - 1);
+        }
+      });
+    }
+  }
+  ASSERT_EQ(lazy.memory_usage(), LazyBlockTable::memory(BlockSize));
+}
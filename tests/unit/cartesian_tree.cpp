@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+#include "cartesian_tree.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  template <typename T>
+  std::vector<std::pair<std::size_t, T>> in_order(const Treap<T> &tree) {
+    std::vector<std::pair<std::size_t, T>> nodes;
+    for (auto &&[key, priority] : tree) {
+      nodes.emplace_back(key, priority);
+    }
+    return nodes;
+  }
+
+  template <typename T>
+  std::vector<std::pair<std::size_t, T>> reverse_order(const Treap<T> &tree) {
+    std::vector<std::pair<std::size_t, T>> nodes;
+    for (auto it = tree.rbegin(); it != tree.rend(); ++it) {
+      nodes.emplace_back(*it);
+    }
+    std::reverse(nodes.begin(), nodes.end());
+    return nodes;
+  }
+
+  std::vector<int> random_array(std::size_t size) {
+    std::mt19937 engine {std::random_device{}()};
+    std::uniform_int_distribution<int> distr(-1000, 1000);
+    std::vector<int> array(size);
+    std::generate(array.begin(), array.end(), [&] { return distr(engine); });
+    return array;
+  }
+
+  // both trees have the same nodes linked the same way
+  template <typename T>
+  bool same_shape(const Treap<T> &lhs, const Treap<T> &rhs) {
+    using node_pointer = typename Treap<T>::const_pointer;
+    std::vector<std::pair<node_pointer, node_pointer>> stack {{lhs.root(), rhs.root()}};
+    while (!stack.empty()) {
+      auto [lhs_node, rhs_node] = stack.back();
+      stack.pop_back();
+      if (!lhs_node || !rhs_node) {
+        if (lhs_node != rhs_node) { return false; }
+        continue;
+      }
+      if (lhs_node->key() != rhs_node->key() ||
+          lhs_node->priority() != rhs_node->priority()) {
+        return false;
+      }
+      stack.emplace_back(lhs_node->left(), rhs_node->left());
+      stack.emplace_back(lhs_node->right(), rhs_node->right());
+    }
+    return true;
+  }
+
+} // <--- namespace
+
+TEST(Treap, Copy1) {
+  auto array = random_array(1000);
+  Treap tree(array.begin(), array.end());
+  Treap copy {tree};
+  ASSERT_EQ(copy.size(), tree.size());
+  ASSERT_EQ(in_order(copy), in_order(tree));
+  ASSERT_EQ(reverse_order(copy), in_order(tree));
+}
+
+TEST(Treap, Split1) {
+  static constexpr std::size_t Size = 300;
+
+  auto array = random_array(Size);
+  Treap tree(array.begin(), array.end());
+  auto nodes = in_order(tree);
+  for (std::size_t key = 0; key < Size; key += 7) {
+    auto [left, right] = Treap<int>::split(tree, key);
+    ASSERT_EQ(left.size(), key + 1);
+    ASSERT_EQ(right.size(), Size - key - 1);
+    ASSERT_EQ(in_order(left), decltype(nodes)(nodes.begin(), nodes.begin() + key + 1));
+    ASSERT_EQ(in_order(right), decltype(nodes)(nodes.begin() + key + 1, nodes.end()));
+    ASSERT_EQ(reverse_order(right), in_order(right));
+    // the original tree is untouched
+    ASSERT_EQ(in_order(tree), nodes);
+  }
+}
+
+TEST(Treap, Merge1) {
+  static constexpr std::size_t Size = 300;
+
+  auto array = random_array(Size);
+  Treap tree(array.begin(), array.end());
+  auto nodes = in_order(tree);
+  for (std::size_t key = 0; key < Size; key += 5) {
+    auto [left, right] = Treap<int>::split(tree, key);
+    auto merged = Treap<int>::merge(std::move(left), std::move(right));
+    ASSERT_EQ(merged.size(), Size);
+    ASSERT_EQ(in_order(merged), nodes);
+    ASSERT_EQ(reverse_order(merged), nodes);
+    // copy of the tree made of several spans
+    Treap copy {merged};
+    ASSERT_EQ(in_order(copy), nodes);
+  }
+}
+
+TEST(Treap, Merge2) {
+  // the tree is a single path, recursive implementations overflow the stack
+  static constexpr std::size_t Size = 1000000;
+
+  std::vector<int> array(Size);
+  std::iota(array.begin(), array.end(), 0);
+  Treap tree(array.begin(), array.end());
+  for (auto key : {Size / 2, std::size_t{0}, Size - 2}) {
+    auto [left, right] = Treap<int>::split(std::move(tree), key);
+    tree = Treap<int>::merge(std::move(left), std::move(right));
+  }
+  Treap copy {tree};
+  ASSERT_EQ(copy.size(), Size);
+  ASSERT_TRUE(std::equal(copy.begin(), copy.end(), array.begin(),
+                         [](auto &&node, auto &&value) { return node.second == value; }));
+}
+
+TEST(Treap, Merge3) {
+  static constexpr std::size_t Size = 500;
+
+  // few distinct values, so equal priorities meet on the spines
+  auto array = random_array(Size);
+  for (auto &&value : array) { value %= 5; }
+  Treap whole(array.begin(), array.end());
+  for (std::size_t border = 0; border <= Size; border += 25) {
+    // the trees of adjacent segments, keys of the second one start at the border
+    Treap left(array.begin(), array.begin() + border);
+    Treap right(array.begin() + border, array.end(), border);
+    auto merged = Treap<int>::merge(std::move(left), std::move(right));
+    ASSERT_EQ(merged.size(), Size);
+    ASSERT_EQ(in_order(merged), in_order(whole));
+    ASSERT_TRUE(same_shape(merged, whole));
+  }
+
+  // both numbered from 0
+  Treap left(array.begin(), array.begin() + 10);
+  Treap right(array.begin() + 10, array.end());
+  ASSERT_THROW(Treap<int>::merge(std::move(left), std::move(right)), std::invalid_argument);
+}
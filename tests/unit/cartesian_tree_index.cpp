@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <utility>
+
+#include "cartesian_tree_index.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::mt19937 engine {std::random_device{}()};
+
+  // the tree of [l, r] hangs from its last minimum
+  void naive_tree(const std::vector<int> &v, std::size_t l, std::size_t r,
+                  std::size_t parent, std::size_t depth,
+                  std::vector<std::size_t> &parents, std::vector<std::size_t> &depths,
+                  std::vector<std::pair<std::size_t, std::size_t>> &subtrees) {
+    auto root = l;
+    for (auto id = l; id <= r; ++id) {
+      if (v[id] <= v[root]) { root = id; }
+    }
+    parents[root]  = parent;
+    depths[root]   = depth;
+    subtrees[root] = {l, r};
+    if (root > l) { naive_tree(v, l, root - 1, root, depth + 1, parents, depths, subtrees); }
+    if (root < r) { naive_tree(v, root + 1, r, root, depth + 1, parents, depths, subtrees); }
+  }
+
+  std::size_t naive_ancestor(const std::vector<std::size_t> &parents,
+                             std::size_t node, std::size_t k) {
+    for (; k > 0 && node != no_position; --k) {
+      node = parents[node];
+    }
+    return node;
+  }
+
+} // <--- namespace
+
+TEST(CartesianTreeIndex, Tree1) {
+  std::vector<int> v {3, 1, 4, 1, 5, 9, 2, 6};
+  CartesianTreeIndex tree(v.begin(), v.end());
+  ASSERT_EQ(tree.size(), v.size());
+  ASSERT_EQ(tree.root(), 3);
+  ASSERT_EQ(tree.parent(3), no_position);
+  ASSERT_EQ(tree.parent(1), 3);
+  ASSERT_EQ(tree.parent(5), 4);
+  ASSERT_EQ(tree.depth(5), 3);
+  ASSERT_EQ(tree.subtree(1), std::make_pair(std::size_t{0}, std::size_t{2}));
+  ASSERT_EQ(tree.subtree(6), std::make_pair(std::size_t{4}, std::size_t{7}));
+  ASSERT_EQ(tree.kth_ancestor(5, 2), 6);
+  ASSERT_EQ(tree.kth_ancestor(5, 3), 3);
+  ASSERT_EQ(tree.kth_ancestor(5, 4), no_position);
+  ASSERT_EQ(tree.level_ancestor(5, 1), 6);
+
+  std::vector<int> empty;
+  ASSERT_EQ(CartesianTreeIndex(empty.begin(), empty.end()).size(), 0);
+}
+
+TEST(CartesianTreeIndex, Tree2) {
+  for (std::size_t size : {1, 2, 17, 1000, 5000}) {
+    for (int max : {3, 1000000}) {
+      std::vector<int> v(size);
+      std::generate(v.begin(), v.end(), [max] { return static_cast<int>(engine() % max); });
+      // sorted arrays give deep paths
+      for (int layout = 0; layout < 3; ++layout) {
+        if (layout == 1) { std::sort(v.begin(), v.end()); }
+        if (layout == 2) { std::reverse(v.begin(), v.end()); }
+        std::vector<std::size_t> parents(size), depths(size);
+        std::vector<std::pair<std::size_t, std::size_t>> subtrees(size);
+        naive_tree(v, 0, size - 1, no_position, 0, parents, depths, subtrees);
+
+        CartesianTreeIndex tree(v.begin(), v.end());
+        for (std::size_t id = 0; id < size; ++id) {
+          ASSERT_EQ(tree.parent(id), parents[id]);
+          ASSERT_EQ(tree.depth(id), depths[id]);
+          ASSERT_EQ(tree.subtree(id), subtrees[id]);
+          auto [first, last] = subtrees[id];
+          ASSERT_EQ(*std::min_element(v.begin() + first, v.begin() + last + 1), v[id]);
+          ASSERT_TRUE(first == 0 || v[first - 1] < v[id]);
+          ASSERT_TRUE(last + 1 == size || v[last + 1] <= v[id]);
+        }
+        for (int query = 0; query < 5000; ++query) {
+          auto node = engine() % size;
+          auto k = engine() % (depths[node] + 2);
+          ASSERT_EQ(tree.kth_ancestor(node, k), naive_ancestor(parents, node, k));
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+#include "codec.hpp"
+#include "pipeline.hpp"
+#include "sparse_table.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::mt19937_64 engine {std::random_device{}()};
+
+} // <--- namespace
+
+TEST(Codec, ZigZag1) {
+  for (std::int64_t value : {std::int64_t{0}, std::int64_t{-1}, std::int64_t{1},
+                             std::numeric_limits<std::int64_t>::min(),
+                             std::numeric_limits<std::int64_t>::max()}) {
+    ASSERT_EQ(codec::unzigzag(codec::zigzag(value)), value);
+  }
+  ASSERT_EQ(codec::zigzag(-1), 1);
+  ASSERT_EQ(codec::zigzag(1), 2);
+}
+
+TEST(Codec, Pack1) {
+  for (unsigned width = 0; width <= 64; ++width) {
+    auto mask = (width == 64 ? ~codec::word_type{0} : (codec::word_type{1} << width) - 1);
+    std::vector<codec::word_type> values(codec::block_size);
+    for (auto &&value : values) {
+      value = engine() & mask;
+    }
+    std::vector<codec::word_type> words(codec::packed_words(width));
+    codec::pack(values.data(), width, words.data());
+    std::vector<codec::word_type> unpacked(codec::block_size);
+    codec::unpack(words.data(), width, unpacked.data());
+    ASSERT_EQ(unpacked, values);
+  }
+}
+
+TEST(Codec, Blocks1) {
+  std::stringstream stream;
+  std::vector<std::vector<std::int64_t>> blocks;
+  std::uniform_int_distribution<std::int64_t> any;
+  for (std::size_t count : {1, 5, 127, 128, 0, 128}) {
+    std::vector<std::int64_t> block(count);
+    for (auto &&value : block) {
+      value = (count == 128 ? any(engine) : static_cast<std::int64_t>(engine() % 100) - 50);
+    }
+    blocks.push_back(block);
+  }
+  blocks.push_back({std::numeric_limits<std::int64_t>::min(),
+                    std::numeric_limits<std::int64_t>::max(), 0});
+  {
+    codec::Writer writer {stream};
+    std::int64_t prev = 0;
+    for (auto &&block : blocks) {
+      writer.block(block.data(), block.size(), &prev);
+      writer.block(block.data(), block.size());
+    }
+  }
+  codec::Reader reader {stream};
+  std::int64_t prev = 0;
+  for (auto &&block : blocks) {
+    std::vector<std::int64_t> deltas(block.size()), values(block.size());
+    reader.block(deltas.data(), block.size(), &prev);
+    reader.block(values.data(), block.size());
+    ASSERT_EQ(deltas, block);
+    ASSERT_EQ(values, block);
+  }
+}
+
+TEST(Codec, Blocks2) {
+  // sorted data takes a few bits per value
+  std::vector<std::int64_t> values(codec::block_size);
+  for (std::size_t id = 0; id < values.size(); ++id) {
+    values[id] = 1000000 + 3 * id;
+  }
+  std::stringstream stream;
+  {
+    codec::Writer writer {stream};
+    std::int64_t prev = 999997;
+    writer.block(values.data(), values.size(), &prev);
+  }
+  // magic, one byte of the base and one of the width
+  ASSERT_EQ(stream.str().size(), codec::magic.size() + 2);
+  codec::Reader reader {stream};
+  std::vector<std::int64_t> decoded(values.size());
+  std::int64_t prev = 999997;
+  reader.block(decoded.data(), decoded.size(), &prev);
+  ASSERT_EQ(decoded, values);
+  ASSERT_THROW(reader.varint(), std::runtime_error);
+
+  std::stringstream text {"5 1 2 3 4 5"};
+  ASSERT_THROW(codec::Reader {text}, std::runtime_error);
+}
+
+TEST(Codec, Pipeline1) {
+  std::vector<int> v(10000);
+  for (auto &&value : v) {
+    value = static_cast<int>(engine());
+  }
+  std::vector<range_query_type> queries(100000);
+  for (auto &&[l, r] : queries) {
+    l = engine() % v.size(), r = engine() % v.size();
+  }
+
+  std::stringstream input;
+  {
+    codec::Writer writer {input};
+    writer.varint(queries.size());
+    std::int64_t prev = 0;
+    codec::write_queries(writer, queries, prev);
+  }
+  codec::Reader reader {input};
+  codec::QueryReader query_reader {reader};
+  std::stringstream output;
+  SparseTable sparse(v.begin(), v.end(), v.size());
+  {
+    QueryPipeline pipeline {QueryPipeline::binary_queries(query_reader), output,
+                            DataFormat::binary, 2};
+    pipeline.answer(sparse);
+  }
+
+  codec::Reader answers_reader {output};
+  auto answers = codec::read_answers(answers_reader);
+  ASSERT_EQ(answers.size(), queries.size());
+  for (std::size_t id = 0; id < queries.size(); ++id) {
+    ASSERT_EQ(answers[id], sparse.ans_query(queries[id]));
+  }
+}
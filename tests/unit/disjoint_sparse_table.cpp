@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "disjoint_sparse_table.hpp"
+#include "range_queries.hpp"
+#include "sparse_table.hpp"
+#include "rmq.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  // fold of v[l..r] by op, computed directly
+  template <typename T, typename Operation>
+  T fold(const std::vector<T> &v, std::size_t l, std::size_t r, Operation op) {
+    return std::accumulate(v.begin() + l + 1, v.begin() + r + 1, v[l], op);
+  }
+
+  template <typename T, typename Operation>
+  void check_all_queries(const std::vector<T> &v, Operation op) {
+    DisjointSparseTable table(v.begin(), v.end(), op);
+    ASSERT_EQ(table.size(), v.size());
+    for (std::size_t l = 0; l < v.size(); ++l) {
+      for (std::size_t r = l; r < v.size(); ++r) {
+        ASSERT_EQ(table.ans_query({l, r}), fold(v, l, r, op));
+      }
+    }
+  }
+
+} // <--- namespace
+
+TEST(DisjointSparseTable, Sum1) {
+  DisjointSparseTable<int> table {5};
+  ASSERT_EQ(table.ans_query({0, 0}), 5);
+  ASSERT_TRUE(DisjointSparseTable<int>{}.empty());
+}
+
+TEST(DisjointSparseTable, Sum2) {
+  std::mt19937 engine {std::random_device{}()};
+  std::uniform_int_distribution<long long> value(-1000, 1000);
+  for (std::size_t size : {2, 3, 64, 65, 300}) {
+    std::vector<long long> v(size);
+    std::generate(v.begin(), v.end(), [&] { return value(engine); });
+    check_all_queries(v, std::plus<long long>{});
+  }
+}
+
+TEST(DisjointSparseTable, Xor1) {
+  std::mt19937 engine {std::random_device{}()};
+  std::vector<unsigned> v(257);
+  std::generate(v.begin(), v.end(), [&] { return engine(); });
+  check_all_queries(v, std::bit_xor<unsigned>{});
+}
+
+TEST(DisjointSparseTable, Gcd1) {
+  std::mt19937 engine {std::random_device{}()};
+  std::uniform_int_distribution<int> value(1, 60);
+  std::vector<int> v(200);
+  std::generate(v.begin(), v.end(), [&] { return value(engine) * 6; });
+  check_all_queries(v, [](int lhs, int rhs) { return std::gcd(lhs, rhs); });
+}
+
+// the operation is not commutative, so the order of folds is checked too
+TEST(DisjointSparseTable, Concatenation1) {
+  std::vector<std::string> v;
+  for (char symbol = 'a'; symbol <= 'z'; ++symbol) {
+    v.emplace_back(1, symbol);
+  }
+  check_all_queries(v, std::plus<std::string>{});
+}
+
+TEST(DisjointSparseTable, Memory1) {
+  std::vector<int> v(1000, 1);
+  DisjointSparseTable table(v.begin(), v.end());
+  ASSERT_EQ(table.memory_usage().parts(),
+            DisjointSparseTable<int>::estimate_memory(v.size()).parts());
+}
+
+TEST(RangeQueries, AllEngines1) {
+  static constexpr std::size_t Size = 20000;
+
+  std::mt19937 engine {std::random_device{}()};
+  std::uniform_int_distribution<int> value(-100000, 100000);
+  std::uniform_int_distribution<std::size_t> index(0, Size - 1);
+  std::vector<int> v(Size);
+  std::generate(v.begin(), v.end(), [&] { return value(engine); });
+  std::vector<range_query_type> queries(100000);
+  std::generate(queries.begin(), queries.end(), [&] {
+    return std::make_pair(index(engine), index(engine));
+  });
+
+  SparseTable sparse(v.begin(), v.end(), v.size());
+  RmqSolver rmq_solver(v.begin(), v.end());
+  auto min = [](int lhs, int rhs) { return std::min(lhs, rhs); };
+  DisjointSparseTable disjoint(v.begin(), v.end(), min);
+
+  auto expected = ans_queries(sparse, queries, 1);
+  ASSERT_EQ(ans_queries(sparse, queries, 4), expected);
+  ASSERT_EQ(ans_queries(rmq_solver, queries, 4), expected);
+  ASSERT_EQ(ans_queries(disjoint, queries, 4), expected);
+  for (std::size_t id = 0; id < queries.size(); id += 97) {
+    auto [l, r] = queries[id];
+    ASSERT_EQ(expected[id], fold(v, std::min(l, r), std::max(l, r), min));
+  }
+}
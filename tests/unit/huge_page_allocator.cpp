@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "huge_page_allocator.hpp"
+#include "sparse_table.hpp"
+#include "rmq.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  auto dice(int min, int max) {
+    static std::uniform_int_distribution<int> distr(min, max);
+    static std::random_device device;
+    static std::mt19937 engine {device()};
+    return distr(engine);
+  }
+
+} // <--- namespace
+
+TEST(HugePageAllocator, Vector1) {
+  for (auto pages : {Pages::usual, Pages::transparent, Pages::hugetlb}) {
+    for (auto numa : {NumaPolicy::local, NumaPolicy::interleave}) {
+      HugePageAllocator<long> alloc {pages, numa};
+      // both small and mapped allocations
+      for (std::size_t size : {10ul, HugePageAllocator<long>::huge_page_size + 3}) {
+        std::vector<long, HugePageAllocator<long>> v(size, 0, alloc);
+        std::iota(v.begin(), v.end(), 0l);
+        ASSERT_EQ(v.back(), static_cast<long>(size - 1));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(v.data()) % alignof(long), 0);
+      }
+    }
+  }
+}
+
+TEST(HugePageAllocator, Sparse1) {
+  static constexpr int ArrSize = 1000;
+
+  std::vector array(ArrSize, 0);
+  std::generate(array.begin(), array.end(), [] { return dice(-1000, 1000); });
+  SparseTable sparse_t(array.cbegin(), array.cend(), array.size(),
+                       HugePageAllocator<int> {Pages::transparent});
+  for (int i = 0; i < ArrSize; i += 3) {
+    for (int j = i; j < ArrSize; ++j) {
+      ASSERT_EQ(sparse_t.min({i, j}), *std::min_element(std::addressof(array[i]),
+                                                        std::addressof(array[j + 1])));
+    }
+  }
+}
+
+TEST(HugePageAllocator, RMQ1) {
+  // big enough for the euler tour and the tables to be mapped
+  static constexpr int Size = 1 << 19;
+
+  std::vector<int> v(Size);
+  std::generate(v.begin(), v.end(), [] { return dice(-100000, 100000); });
+  RmqSolver rmq_solver(v.begin(), v.end(), RmqSolver<int>::theoretical_block_size,
+                       HugePageAllocator<int> {Pages::transparent,
+                                               NumaPolicy::interleave});
+  SparseTable sparse(v.begin(), v.end(), v.size());
+  std::mt19937 engine {std::random_device{}()};
+  std::uniform_int_distribution<std::size_t> index(0, Size - 1);
+  for (int i = 0; i < 100000; ++i) {
+    auto l = index(engine), r = index(engine);
+    if (l > r) { std::swap(l, r); }
+    ASSERT_EQ(rmq_solver.ans_query({l, r}), sparse.min({l, r}));
+  }
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "implicit_treap.hpp"
+
+using namespace yLAB;
+
+TEST(ImplicitTreap, Build1) {
+  ImplicitTreap<int> treap;
+  ASSERT_TRUE(treap.empty());
+  ASSERT_THROW(treap.range_min({0, 0}), std::out_of_range);
+  ASSERT_THROW(treap.erase(0), std::out_of_range);
+  treap.insert(0, 5);
+  ASSERT_EQ(treap.range_min({0, 0}), 5);
+}
+
+TEST(ImplicitTreap, Build2) {
+  // sorted input is the worst case for Treap, here it's just a random tree
+  static constexpr int Size = 100000;
+
+  std::vector<int> v(Size);
+  std::iota(v.begin(), v.end(), 0);
+  ImplicitTreap treap(v.begin(), v.end());
+  ASSERT_EQ(treap.size(), Size);
+  for (int i = 0; i < Size; i += 97) {
+    ASSERT_EQ(treap[i], i);
+    ASSERT_EQ(treap.range_min({i, Size - 1}), i);
+  }
+}
+
+TEST(ImplicitTreap, Operations1) {
+  static constexpr int OperationsNum = 20000;
+
+  std::mt19937 engine {std::random_device{}()};
+  std::uniform_int_distribution<int> value(-1000, 1000);
+  std::vector<int> v {1, 2, 3};
+  ImplicitTreap<int> treap {1, 2, 3};
+  for (int i = 0; i < OperationsNum; ++i) {
+    std::uniform_int_distribution<std::size_t> pos(0, v.size());
+    if (auto action = engine() % 3; action == 0 || v.empty()) {
+      auto id = pos(engine);
+      auto val = value(engine);
+      v.insert(v.begin() + id, val);
+      treap.insert(id, val);
+    } else if (action == 1) {
+      auto id = pos(engine) % v.size();
+      v.erase(v.begin() + id);
+      treap.erase(id);
+    } else {
+      auto l = pos(engine) % v.size(), r = pos(engine) % v.size();
+      ASSERT_EQ(treap.range_min({l, r}),
+                *std::min_element(v.begin() + std::min(l, r),
+                                  v.begin() + std::max(l, r) + 1));
+    }
+    ASSERT_EQ(treap.size(), v.size());
+  }
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    ASSERT_EQ(treap[i], v[i]);
+  }
+}
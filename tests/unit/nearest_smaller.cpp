@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "nearest_smaller.hpp"
+#include "sparse_table.hpp"
+#include "rmq.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::mt19937 engine {std::random_device{}()};
+
+  std::vector<int> random_array(std::size_t size, int max) {
+    std::vector<int> v(size);
+    std::generate(v.begin(), v.end(), [max] { return static_cast<int>(engine() % max); });
+    return v;
+  }
+
+  std::size_t naive_next_less(const std::vector<int> &v, std::size_t pos, int x) {
+    for (auto id = pos + 1; id < v.size(); ++id) {
+      if (v[id] < x) { return id; }
+    }
+    return no_position;
+  }
+
+  std::size_t naive_prev_less(const std::vector<int> &v, std::size_t pos, int x) {
+    for (auto id = pos; id-- > 0;) {
+      if (v[id] < x) { return id; }
+    }
+    return no_position;
+  }
+
+  // the sequential stack
+  std::vector<std::size_t> stack_next_smaller(const std::vector<int> &v) {
+    std::vector<std::size_t> next(v.size(), no_position), stack;
+    for (std::size_t id = 0; id < v.size(); ++id) {
+      while (!stack.empty() && v[stack.back()] > v[id]) {
+        next[stack.back()] = id;
+        stack.pop_back();
+      }
+      stack.push_back(id);
+    }
+    return next;
+  }
+
+} // <--- namespace
+
+TEST(NearestSmaller, Bulk1) {
+  std::vector<int> v {3, 1, 4, 1, 5, 9, 2, 6};
+  ASSERT_EQ(next_smaller(v), (std::vector<std::size_t> {1, no_position, 3, no_position,
+                                                         6, 6, no_position, no_position}));
+  ASSERT_EQ(prev_smaller(v), (std::vector<std::size_t> {no_position, no_position, 1,
+                                                         no_position, 3, 4, 3, 6}));
+  ASSERT_TRUE(next_smaller(std::vector<int> {}).empty());
+}
+
+TEST(NearestSmaller, Bulk2) {
+  for (std::size_t size : {1, 2, 1000, 100000, 300001}) {
+    for (int max : {3, 1000000}) {
+      auto v = random_array(size, max);
+      // sorted arrays leave every element of a chunk unresolved
+      for (int layout = 0; layout < 3; ++layout) {
+        if (layout == 1) { std::sort(v.begin(), v.end()); }
+        if (layout == 2) { std::reverse(v.begin(), v.end()); }
+        auto expected_next = stack_next_smaller(v);
+        std::vector<int> reversed(v.rbegin(), v.rend());
+        auto expected_prev = stack_next_smaller(reversed);
+        std::reverse(expected_prev.begin(), expected_prev.end());
+        for (auto &&pos : expected_prev) {
+          pos = (pos == no_position ? pos : size - 1 - pos);
+        }
+        for (std::size_t threads_num : {1, 3, 8}) {
+          ASSERT_EQ(next_smaller(v, threads_num), expected_next);
+          ASSERT_EQ(prev_smaller(v, threads_num), expected_prev);
+        }
+      }
+    }
+  }
+}
+
+TEST(NearestSmaller, Queries1) {
+  for (std::size_t size : {1, 2, 17, 5000}) {
+    auto v = random_array(size, 100);
+    RmqSolver rmq_solver(v.begin(), v.end());
+    SparseTable sparse(v.begin(), v.end(), v.size());
+    for (int query = 0; query < 2000; ++query) {
+      auto pos = engine() % size;
+      auto x = static_cast<int>(engine() % 101);
+      auto next = naive_next_less(v, pos, x), prev = naive_prev_less(v, pos, x);
+      ASSERT_EQ(next_less(rmq_solver, size, pos, x), next);
+      ASSERT_EQ(next_less(sparse, size, pos, x), next);
+      ASSERT_EQ(prev_less(rmq_solver, pos, x), prev);
+      ASSERT_EQ(prev_less(sparse, pos, x), prev);
+    }
+  }
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+#include "number_reader.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::vector<std::int64_t> read_all(const std::string &input) {
+    std::istringstream is {input};
+    NumberReader reader {is};
+    std::vector<std::int64_t> numbers;
+    std::int64_t number;
+    while (reader.read(number)) {
+      numbers.push_back(number);
+    }
+    return numbers;
+  }
+
+} // <--- namespace
+
+TEST(NumberReader, Read1) {
+  using numbers = std::vector<std::int64_t>;
+  ASSERT_EQ(read_all("5 1 -1 2 0 5\n"), (numbers {5, 1, -1, 2, 0, 5}));
+  // the last number ends with the input
+  ASSERT_EQ(read_all("5 1 -1 2 0 5"), (numbers {5, 1, -1, 2, 0, 5}));
+  ASSERT_EQ(read_all("\t42"), (numbers {42}));
+  ASSERT_TRUE(read_all("").empty());
+  ASSERT_TRUE(read_all(" \n ").empty());
+  ASSERT_THROW(read_all("1 2x 3"), std::runtime_error);
+
+  std::istringstream is {"7"};
+  NumberReader reader {is};
+  ASSERT_EQ(reader.read<int>(), 7);
+  ASSERT_THROW(reader.read<int>(), std::runtime_error);
+}
+
+TEST(NumberReader, Read2) {
+  // a number cut by the end of the buffer, with and without whitespace after it
+  for (std::string tail : {"", "\n", " 17"}) {
+    std::string input(NumberReader::buffer_size - 3, ' ');
+    input += "123456" + tail;
+    auto expected = tail == " 17" ? std::vector<std::int64_t> {123456, 17}
+                                  : std::vector<std::int64_t> {123456};
+    ASSERT_EQ(read_all(input), expected);
+  }
+}
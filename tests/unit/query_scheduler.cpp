@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <set>
+#include <sstream>
+#include <limits>
+#include <functional>
+#include <cstdint>
+
+#include "query_scheduler.hpp"
+#include "pipeline.hpp"
+#include "sparse_table.hpp"
+#include "rmq.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::mt19937_64 engine {std::random_device{}()};
+
+} // <--- namespace
+
+TEST(QueryScheduler, RadixSort1) {
+  using item_type = std::pair<std::uint32_t, std::size_t>;
+
+  for (std::size_t size : {0, 1, 255, 256, 100000}) {
+    for (std::size_t threads_num : {1, 3, 8}) {
+      std::vector<item_type> items(size);
+      for (std::size_t id = 0; id < size; ++id) {
+        items[id] = {static_cast<std::uint32_t>(engine() % 5000), id};
+      }
+      auto expected = items;
+      std::stable_sort(expected.begin(), expected.end(),
+                       [](auto &&lhs, auto &&rhs) { return lhs.first < rhs.first; });
+      parallel_radix_sort(items, 13, [](const item_type &item) { return item.first; },
+                          threads_num);
+      ASSERT_EQ(items, expected);
+    }
+  }
+}
+
+TEST(QueryScheduler, Hilbert1) {
+  for (unsigned order = 0; order <= 5; ++order) {
+    std::uint64_t side = 1 << order;
+    // a bijection of the cells, neighbouring positions are neighbouring cells
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> cells(side * side);
+    std::set<std::uint64_t> indexes;
+    for (std::uint64_t x = 0; x < side; ++x) {
+      for (std::uint64_t y = 0; y < side; ++y) {
+        auto index = hilbert_index(x, y, order);
+        ASSERT_LT(index, side * side);
+        indexes.insert(index);
+        cells[index] = {x, y};
+      }
+    }
+    ASSERT_EQ(indexes.size(), side * side);
+    for (std::size_t id = 1; id < cells.size(); ++id) {
+      auto [x1, y1] = cells[id - 1];
+      auto [x2, y2] = cells[id];
+      ASSERT_EQ((x1 > x2 ? x1 - x2 : x2 - x1) + (y1 > y2 ? y1 - y2 : y2 - y1), 1);
+    }
+  }
+  static_assert(hilbert_index(0, 0, 1) == 0 && hilbert_index(0, 1, 1) == 1 &&
+                hilbert_index(1, 1, 1) == 2 && hilbert_index(1, 0, 1) == 3);
+}
+
+TEST(QueryScheduler, Answers1) {
+  std::vector<int> v(100000);
+  for (auto &&value : v) {
+    value = static_cast<int>(engine());
+  }
+  RmqSolver rmq_solver(v.begin(), v.end());
+  SparseTable sparse(v.begin(), v.end(), v.size());
+
+  for (std::size_t queries_num : {0, 1, 1000, 200000}) {
+    std::vector<range_query_type> queries(queries_num);
+    for (auto &&[l, r] : queries) {
+      l = engine() % v.size(), r = std::min(v.size() - 1, l + engine() % 1000);
+    }
+    auto expected = ans_queries(sparse, queries, 1);
+    for (auto order : {QueryOrder::input, QueryOrder::left, QueryOrder::hilbert}) {
+      auto positions = schedule_queries(queries, order, 4);
+      auto sorted = positions;
+      std::sort(sorted.begin(), sorted.end());
+      for (std::size_t id = 0; id < sorted.size(); ++id) {
+        ASSERT_EQ(sorted[id], id);
+      }
+      // the borders fit into the key, so the left borders are sorted exactly
+      if (order == QueryOrder::left) {
+        ASSERT_TRUE(std::is_sorted(positions.begin(), positions.end(),
+                                   [&](auto lhs, auto rhs) {
+                                     return queries[lhs].first < queries[rhs].first;
+                                   }));
+      }
+      ASSERT_EQ(ans_queries(rmq_solver, queries, order, 4), expected);
+    }
+  }
+}
+
+TEST(QueryScheduler, Dedup1) {
+  constexpr auto max = std::numeric_limits<std::size_t>::max();
+
+  std::vector<range_query_type> pool {{0, 0}, {3, 7}, {7, 3}, {5, 5}, {0, 100000}};
+  for (int id = 0; id < 100; ++id) {
+    auto l = engine() % 100000;
+    pool.emplace_back(l, l + engine() % 100);
+  }
+  // the borders don't fit into one key together
+  std::vector<range_query_type> wide_pool {{max, max}, {0, max}, {max - 1, 1}, {1, 2}};
+  for (auto &&pool : {pool, wide_pool}) {
+    for (std::size_t queries_num : {0, 1, 100000}) {
+      std::vector<range_query_type> queries(queries_num);
+      for (auto &&query : queries) {
+        query = pool[engine() % pool.size()];
+      }
+      auto [distinct, index] = dedup_queries(queries, 3);
+      ASSERT_TRUE(std::adjacent_find(distinct.begin(), distinct.end(),
+                                     std::greater_equal<>{}) == distinct.end());
+      ASSERT_LE(distinct.size(), pool.size());
+      ASSERT_EQ(index.size(), queries.size());
+      for (std::size_t id = 0; id < queries.size(); ++id) {
+        ASSERT_EQ(distinct[index[id]], queries[id]);
+      }
+    }
+  }
+}
+
+TEST(QueryScheduler, Pipeline1) {
+  std::vector<int> v(10000);
+  for (auto &&value : v) {
+    value = static_cast<int>(engine());
+  }
+  SparseTable sparse(v.begin(), v.end(), v.size());
+  std::vector<range_query_type> queries(300000);
+  for (auto &&[l, r] : queries) {
+    l = engine() % 100, r = v.size() - 1 - engine() % 100;
+  }
+
+  std::ostringstream os;
+  std::size_t next = 0;
+  auto source = [&](std::vector<range_query_type> &chunk, std::size_t max_queries) {
+    for (; next < queries.size() && chunk.size() < max_queries; ++next) {
+      chunk.push_back(queries[next]);
+    }
+  };
+  QueryPipeline pipeline {source, os, DataFormat::text, 2, QueryOrder::hilbert, true};
+  pipeline.answer(sparse);
+  ASSERT_EQ(pipeline.queries_number(), queries.size());
+  ASSERT_LE(pipeline.distinct_number(), 100 * 100 * 2);
+
+  std::istringstream is {os.str()};
+  for (auto &&query : queries) {
+    int answer = 0;
+    ASSERT_TRUE(is >> answer);
+    ASSERT_EQ(answer, sparse.ans_query(query));
+  }
+}
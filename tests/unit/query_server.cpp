@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "query_server.hpp"
+#include "sparse_table.hpp"
+#include "rmq.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::vector<range_query_type> random_queries(std::size_t array_size,
+                                               std::size_t queries_num,
+                                               std::mt19937 &engine) {
+    std::uniform_int_distribution<std::size_t> index(0, array_size - 1);
+    std::vector<range_query_type> queries(queries_num);
+    for (auto &&[l, r] : queries) {
+      l = index(engine), r = index(engine);
+    }
+    return queries;
+  }
+
+} // <--- namespace
+
+TEST(QueryServer, Session1) {
+  std::mt19937 engine {std::random_device{}()};
+  std::vector<int> v(10000);
+  std::generate(v.begin(), v.end(), [&] { return static_cast<int>(engine()); });
+  RmqSolver rmq_solver(v.begin(), v.end());
+  SparseTable sparse(v.begin(), v.end(), v.size());
+
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  server::FileDescriptor client {fds[0], "socketpair"}, peer {fds[1], "socketpair"};
+  QueryServer server {rmq_solver, v.size(), 4};
+  std::size_t batches = 0;
+  std::jthread thread {[&] { batches = server.serve(peer.get(), peer.get()); }};
+
+  for (std::size_t queries_num : {1, 1000, 0, 100000}) {
+    auto queries = random_queries(v.size(), queries_num, engine);
+    if (queries.empty()) { continue; }
+    server::send_queries(client.get(), queries);
+    auto answers = server::receive_answers(client.get());
+    ASSERT_EQ(answers.size(), queries.size());
+    for (std::size_t id = 0; id < queries.size(); ++id) {
+      ASSERT_EQ(answers[id], sparse.ans_query(queries[id]));
+    }
+  }
+  server::end_session(client.get());
+  thread.join();
+  ASSERT_EQ(batches, 3);
+}
+
+TEST(QueryServer, Session2) {
+  std::vector<std::int64_t> v {5, -1, 3};
+  SparseTable sparse(v.begin(), v.end(), v.size());
+
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  server::FileDescriptor client {fds[0], "socketpair"}, peer {fds[1], "socketpair"};
+  QueryServer server {sparse, v.size()};
+  std::jthread thread {[&] { server.serve(peer.get(), peer.get()); }};
+
+  server::send_queries(client.get(), {{0, 2}, {2, 2}});
+  ASSERT_EQ(server::receive_answers(client.get()), (std::vector<std::int64_t> {-1, 3}));
+  // the query out of the array ends the session
+  server::send_queries(client.get(), {{0, 3}});
+  ASSERT_THROW(server::receive_answers(client.get()), std::invalid_argument);
+  thread.join();
+}
+
+TEST(QueryServer, Listen1) {
+  auto path = (std::filesystem::temp_directory_path() /
+               ("rmq_test_" + std::to_string(getpid()) + ".sock")).string();
+  std::vector<int> v {3, 1, 4, 1, 5, 9, 2, 6};
+  RmqSolver rmq_solver(v.begin(), v.end());
+  QueryServer server {rmq_solver, v.size()};
+  std::jthread thread {[&] { server.listen(path, 2); }};
+
+  for (int session = 0; session < 2; ++session) {
+    int fd = -1;
+    // the server may not be listening yet
+    while (fd < 0) {
+      try {
+        fd = server::connect(path);
+      } catch (const std::system_error&) {
+        std::this_thread::yield();
+      }
+    }
+    server::FileDescriptor client {fd, "connect"};
+    server::send_queries(client.get(), {{0, 7}, {4, 5}, {6, 7}});
+    ASSERT_EQ(server::receive_answers(client.get()),
+              (std::vector<std::int64_t> {1, 5, 2}));
+    server::end_session(client.get());
+  }
+  thread.join();
+  ASSERT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(QueryServer, Listen2) {
+  auto path = (std::filesystem::temp_directory_path() /
+               ("rmq_test_" + std::to_string(getpid()) + "_2.sock")).string();
+  std::vector<int> v {3, 1, 4, 1, 5, 9, 2, 6};
+  RmqSolver rmq_solver(v.begin(), v.end());
+  QueryServer server {rmq_solver, v.size()};
+
+  // a file which isn't a socket is kept
+  std::filesystem::remove(path);
+  { std::ofstream file {path}; }
+  ASSERT_THROW(server.listen(path, 1), std::runtime_error);
+  ASSERT_TRUE(std::filesystem::is_regular_file(path));
+  std::filesystem::remove(path);
+
+  // a socket left by a closed server is replaced
+  {
+    auto address = server::socket_address(path);
+    server::FileDescriptor stale {::socket(AF_UNIX, SOCK_STREAM, 0), "socket"};
+    ASSERT_EQ(::bind(stale.get(), reinterpret_cast<const sockaddr*>(&address),
+                     sizeof(address)), 0);
+  }
+  ASSERT_TRUE(std::filesystem::is_socket(path));
+  std::jthread thread {[&] { server.listen(path, 1); }};
+
+  int fd = -1;
+  while (fd < 0) {
+    try {
+      fd = server::connect(path);
+    } catch (const std::system_error&) {
+      std::this_thread::yield();
+    }
+  }
+  server::FileDescriptor client {fd, "connect"};
+  // the socket of a live server isn't taken over
+  ASSERT_THROW(server.listen(path, 1), std::runtime_error);
+  server::send_queries(client.get(), {{0, 2}});
+  ASSERT_EQ(server::receive_answers(client.get()), (std::vector<std::int64_t> {1}));
+  server::end_session(client.get());
+  thread.join();
+  ASSERT_FALSE(std::filesystem::exists(path));
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "sparse_table_2d.hpp"
+#include "block_rmq_2d.hpp"
+#include "range_queries.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::vector<int> random_matrix(std::size_t rows, std::size_t cols,
+                                 std::mt19937 &engine) {
+    std::uniform_int_distribution<int> value(-1000, 1000);
+    std::vector<int> matrix(rows * cols);
+    std::generate(matrix.begin(), matrix.end(), [&] { return value(engine); });
+    return matrix;
+  }
+
+  std::vector<rectangle_query_type> random_queries(std::size_t rows, std::size_t cols,
+                                                   std::size_t number,
+                                                   std::mt19937 &engine) {
+    std::uniform_int_distribution<std::size_t> row(0, rows - 1), col(0, cols - 1);
+    std::vector<rectangle_query_type> queries(number);
+    std::generate(queries.begin(), queries.end(), [&] {
+      return rectangle_query_type {{row(engine), row(engine)}, {col(engine), col(engine)}};
+    });
+    return queries;
+  }
+
+  int brute_min(const std::vector<int> &matrix, std::size_t cols,
+                rectangle_query_type query) {
+    auto [rows_range, cols_range] = query;
+    auto [top, bottom] = std::minmax(rows_range.first, rows_range.second);
+    auto [left, right] = std::minmax(cols_range.first, cols_range.second);
+    auto answer = matrix[top * cols + left];
+    for (auto row = top; row <= bottom; ++row) {
+      for (auto col = left; col <= right; ++col) {
+        answer = std::min(answer, matrix[row * cols + col]);
+      }
+    }
+    return answer;
+  }
+
+} // <--- namespace
+
+TEST(Rmq2D, Sparse1) {
+  std::vector<int> matrix {3, 1, 4,
+                           1, 5, 9,
+                           2, 6, 0};
+  SparseTable2D table(matrix.begin(), matrix.end(), 3);
+  ASSERT_EQ(table.rows(), 3);
+  ASSERT_EQ(table.ans_query({{0, 1}, {0, 0}}), 1);
+  ASSERT_EQ(table.ans_query({{0, 1}, {1, 2}}), 1);
+  ASSERT_EQ(table.ans_query({{1, 0}, {2, 2}}), 4);
+  ASSERT_EQ(table.ans_query({{0, 2}, {0, 2}}), 0);
+  ASSERT_THROW(SparseTable2D(matrix.begin(), matrix.end(), 4), std::invalid_argument);
+}
+
+TEST(Rmq2D, Sparse2) {
+  std::mt19937 engine {std::random_device{}()};
+  for (auto [rows, cols] : {std::pair{1, 1}, {1, 50}, {50, 1}, {37, 53}, {64, 64}}) {
+    auto matrix = random_matrix(rows, cols, engine);
+    SparseTable2D table(matrix.begin(), matrix.end(), cols);
+    for (auto &&query : random_queries(rows, cols, 2000, engine)) {
+      ASSERT_EQ(table.ans_query(query), brute_min(matrix, cols, query));
+    }
+  }
+}
+
+TEST(Rmq2D, Block1) {
+  std::mt19937 engine {std::random_device{}()};
+  for (auto [rows, cols] : {std::pair{1, 1}, {1, 70}, {70, 1}, {37, 53}, {100, 90}}) {
+    auto matrix = random_matrix(rows, cols, engine);
+    for (std::size_t tile_sz : {1, 3, 16}) {
+      BlockRmq2D table(matrix.begin(), matrix.end(), cols, tile_sz);
+      for (auto &&query : random_queries(rows, cols, 2000, engine)) {
+        ASSERT_EQ(table.ans_query(query), brute_min(matrix, cols, query));
+      }
+    }
+  }
+}
+
+TEST(Rmq2D, Batch1) {
+  static constexpr std::size_t Rows = 300, Cols = 200;
+
+  std::mt19937 engine {std::random_device{}()};
+  auto matrix  = random_matrix(Rows, Cols, engine);
+  auto queries = random_queries(Rows, Cols, 20000, engine);
+  SparseTable2D sparse(matrix.begin(), matrix.end(), Cols);
+  BlockRmq2D block(matrix.begin(), matrix.end(), Cols);
+
+  auto answers = ans_queries(sparse, queries, 4);
+  ASSERT_EQ(ans_queries(block, queries, 4), answers);
+  for (std::size_t id = 0; id < queries.size(); id += 101) {
+    ASSERT_EQ(answers[id], brute_min(matrix, Cols, queries[id]));
+  }
+}
+
+TEST(Rmq2D, Memory1) {
+  static constexpr std::size_t Rows = 500, Cols = 300;
+
+  std::vector<int> matrix(Rows * Cols, 1);
+  SparseTable2D sparse(matrix.begin(), matrix.end(), Cols);
+  BlockRmq2D block(matrix.begin(), matrix.end(), Cols);
+  ASSERT_EQ(sparse.memory_usage().parts(),
+            SparseTable2D<int>::estimate_memory(Rows, Cols).parts());
+  ASSERT_EQ(block.memory_usage().parts(),
+            BlockRmq2D<int>::estimate_memory(Rows, Cols).parts());
+  ASSERT_LT(4 * block.memory_usage().total(), sparse.memory_usage().total());
+}
@@ -2,8 +2,12 @@
 #include <algorithm>
 #include <random>
 #include <vector>
+#include <sstream>
+#include <iterator>
+#include <cstdint>
 
 #include "rmq.hpp"
+#include "range_queries.hpp"
 #include "cartesian_tree.hpp"
 
 namespace {
@@ -15,6 +19,13 @@ namespace {
     return distr(engine);
   }
 
+  // the blocks are forced with an explicit block size, arrays of up to
+  // sparse_size elements would take a scan or a sparse table otherwise
+  template <typename Solver = yLAB::RmqSolver<int>, typename Container = std::vector<int>>
+  Solver blocks(const Container &array) {
+    return Solver(array.begin(), array.end(), Solver::choose_block_size(array.size()));
+  }
+
 } // <--- namespace
 
 using namespace yLAB;
@@ -22,26 +33,33 @@ using namespace yLAB;
 TEST(RMQ, RMQ1) {
   RmqSolver rmq_solver {1};
   ASSERT_EQ(rmq_solver.ans_query({0, 0}), 1);
+  auto blocks_solver = blocks({1});
+  ASSERT_EQ(blocks_solver.shape(), RmqSolver<int>::Shape::blocks);
+  ASSERT_EQ(blocks_solver.ans_query({0, 0}), 1);
 }
 
 TEST(RMQ, RMQ2) {
   RmqSolver rmq_solver {1, 1};
   ASSERT_EQ(rmq_solver.ans_query({0, 1}), 1);
+  ASSERT_EQ(blocks({1, 1}).ans_query({0, 1}), 1);
 }
 
 TEST(RMQ, RMQ3) {
   RmqSolver rmq_solver {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
   ASSERT_EQ(rmq_solver.ans_query({0, 11}), 1);
+  ASSERT_EQ(blocks({1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}).ans_query({0, 11}), 1);
 }
 
 TEST(RMQ, RMQ4) {
   RmqSolver rmq_solver {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1};
   ASSERT_EQ(rmq_solver.ans_query({0, 11}), -1);
+  ASSERT_EQ(blocks({1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1}).ans_query({0, 11}), -1);
 }
 
 TEST(RMQ, RMQ5) {
   RmqSolver rmq_solver {-1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
   ASSERT_EQ(rmq_solver.ans_query({0, 11}), -1);
+  ASSERT_EQ(blocks({-1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}).ans_query({0, 11}), -1);
 }
 
 TEST(RMQ, RMQ6) {
@@ -50,10 +68,13 @@ TEST(RMQ, RMQ6) {
   std::vector<int> v(Size);
   std::iota(v.begin(), v.end(), -50);
   RmqSolver rmq_solver(v.begin(), v.end());
+  auto blocks_solver = blocks(v);
+  ASSERT_EQ(blocks_solver.shape(), RmqSolver<int>::Shape::blocks);
   SparseTable sparse(v.begin(), v.end(), v.size());
   for (int i = 0; i < Size; ++i) {
     for (int j = i; j < Size; ++j) {
       ASSERT_EQ(rmq_solver.ans_query({i, j}), sparse.min({i, j}));
+      ASSERT_EQ(blocks_solver.ans_query({i, j}), sparse.min({i, j}));
     }
   }
 }
@@ -71,3 +92,217 @@ TEST(RMQ, RMQ7) {
     }
   }
 }
+
+TEST(RMQ, BlockSize1) {
+  static constexpr int Size = 2000;
+  std::vector<int> v(Size);
+  std::generate(v.begin(), v.end(), [] { return dice(-100000, 100000); });
+  SparseTable sparse(v.begin(), v.end(), v.size());
+  for (std::size_t block_sz : {1, 2, 3, 7, 12}) {
+    RmqSolver rmq_solver(v.begin(), v.end(), block_sz);
+    ASSERT_EQ(rmq_solver.block_size(), block_sz);
+    for (int i = 0; i < Size; i += 7) {
+      for (int j = i; j < Size; ++j) {
+        ASSERT_EQ(rmq_solver.ans_query({i, j}), sparse.min({i, j}));
+      }
+    }
+  }
+}
+
+TEST(RMQ, BlockSize2) {
+  using solver = RmqSolver<int>;
+  static constexpr int Size = 5000;
+  std::vector<int> v(Size);
+  // many equal values, dice() keeps the range of its first call
+  std::mt19937 engine {std::random_device{}()};
+  std::uniform_int_distribution<int> value(-100, 100);
+  std::generate(v.begin(), v.end(), [&] { return value(engine); });
+  RmqSolver rmq_solver(v.begin(), v.end(), solver::auto_block_size);
+  ASSERT_EQ(rmq_solver.block_size(), solver::tuned_block_size(2 * Size - 1));
+  SparseTable sparse(v.begin(), v.end(), v.size());
+  for (int i = 0; i < Size; i += 11) {
+    for (int j = i; j < Size; ++j) {
+      ASSERT_EQ(rmq_solver.ans_query({i, j}), sparse.min({i, j}));
+    }
+  }
+}
+
+TEST(RMQ, BlockSize3) {
+  using solver = RmqSolver<int>;
+  std::vector<int> v {3, 1, 2};
+  ASSERT_THROW(solver(v.begin(), v.end(), solver::max_block_size + 1),
+               std::invalid_argument);
+  // block_sz - 1 bits fit in the block type, but the table doesn't fit in memory
+  ASSERT_THROW(solver(v.begin(), v.end(), solver::max_block_size),
+               std::length_error);
+}
+
+TEST(RMQ, Wide1) {
+  static constexpr int Size = 3000;
+  static constexpr std::int64_t Shift = std::int64_t{1} << 40;
+
+  std::vector<std::int64_t> v(Size);
+  std::generate(v.begin(), v.end(), [] { return dice(-100000, 100000) * Shift; });
+  auto rmq_solver = blocks<RmqSolver<std::int64_t>>(v);
+  ASSERT_EQ(rmq_solver.shape(), RmqSolver<std::int64_t>::Shape::blocks);
+  SparseTable sparse(v.begin(), v.end(), v.size());
+  for (int i = 0; i < Size; i += 5) {
+    for (int j = i; j < Size; ++j) {
+      ASSERT_EQ(rmq_solver.ans_query({i, j}), sparse.min({i, j}));
+    }
+  }
+}
+
+TEST(RMQ, Memory1) {
+  using solver = RmqSolver<int>;
+  for (std::size_t size : {1, 2, 7, 1000, 12345}) {
+    // the last one forces the blocks at the theoretical size
+    for (std::size_t block_sz : {solver::theoretical_block_size, std::size_t{1},
+                                 std::size_t{5}, solver::auto_block_size,
+                                 solver::choose_block_size(size)}) {
+      std::vector<int> v(size);
+      std::generate(v.begin(), v.end(), [] { return dice(-1000, 1000); });
+      solver rmq_solver(v.begin(), v.end(), block_sz);
+
+      auto usage    = rmq_solver.memory_usage();
+      auto estimate = solver::estimate_memory(size, block_sz);
+      ASSERT_EQ(usage.parts(), estimate.parts());
+      ASSERT_LE(usage.total(), solver::estimate_peak_memory(size, block_sz));
+    }
+  }
+}
+
+TEST(RMQ, Memory2) {
+  using solver = RmqSolver<int>;
+  static constexpr std::size_t Size = 1000000;
+
+  auto lean_sz = solver::lean_block_size(Size);
+  auto lean    = solver::estimate_memory(Size, lean_sz).total();
+  for (std::size_t block_sz = 1; block_sz < 20; ++block_sz) {
+    ASSERT_LE(lean, solver::estimate_memory(Size, block_sz).total());
+  }
+}
+
+TEST(RMQ, Memory3) {
+  using solver = RmqSolver<int>;
+  static constexpr std::size_t Size = 10000;
+
+  // positions in the Euler tour and depths of a small tree take 32 bits
+  std::vector<int> v(Size);
+  std::generate(v.begin(), v.end(), [] { return dice(-1000, 1000); });
+  solver rmq_solver(v.begin(), v.end(), solver::choose_block_size(Size));
+  auto usage = rmq_solver.memory_usage();
+  ASSERT_EQ(usage["first appearances"], Size * sizeof(std::uint32_t));
+  ASSERT_EQ(usage["heights"], (2 * Size - 1) * sizeof(std::uint32_t));
+
+  ASSERT_EQ(IndexArray<>::index_size(IndexArray<>::max_narrow), sizeof(std::uint32_t));
+  ASSERT_EQ(IndexArray<>::index_size(IndexArray<>::max_narrow + 1), sizeof(std::size_t));
+
+  // a bound above 32 bits keeps the whole size_type
+  IndexArray<> wide;
+  wide.resize(2, IndexArray<>::max_narrow + 1);
+  wide.set(1, IndexArray<>::max_narrow + 1);
+  wide.push_back(7);
+  ASSERT_EQ(wide.size(), 3);
+  ASSERT_EQ(wide[0], 0);
+  ASSERT_EQ(wide[1], IndexArray<>::max_narrow + 1);
+  ASSERT_EQ(wide[2], 7);
+}
+
+TEST(RMQ, Superblocks1) {
+  using solver = RmqSolver<int, std::allocator<int>, SuperblockTable>;
+  for (std::size_t size : {1, 2, 100, 3000}) {
+    // the last one forces the blocks at the theoretical size
+    for (std::size_t block_sz : {std::size_t{1}, std::size_t{2},
+                                 solver::choose_block_size(size)}) {
+      std::vector<int> v(size);
+      std::generate(v.begin(), v.end(), [] { return dice(-1000, 1000); });
+      solver rmq_solver(v.begin(), v.end(), block_sz);
+      ASSERT_EQ(rmq_solver.shape(), solver::Shape::blocks);
+      SparseTable sparse(v.begin(), v.end(), v.size());
+      for (std::size_t i = 0; i < size; i += 3) {
+        for (std::size_t j = i; j < size; ++j) {
+          ASSERT_EQ(rmq_solver.ans_query({i, j}), sparse.min({i, j}));
+        }
+      }
+      ASSERT_EQ(rmq_solver.memory_usage().parts(),
+                solver::estimate_memory(size, block_sz).parts());
+    }
+  }
+}
+
+TEST(RMQ, Lazy1) {
+  using solver = RmqSolver<int, std::allocator<int>, LazyBlockSparseTable>;
+  for (std::size_t size : {1, 2, 100, 3000}) {
+    std::vector<int> v(size);
+    std::generate(v.begin(), v.end(), [] { return dice(-1000, 1000); });
+    auto rmq_solver = blocks<solver>(v);
+    ASSERT_EQ(rmq_solver.shape(), solver::Shape::blocks);
+    auto before = rmq_solver.memory_usage();
+    SparseTable sparse(v.begin(), v.end(), v.size());
+    for (std::size_t i = 0; i < size; i += 3) {
+      for (std::size_t j = i; j < size; ++j) {
+        ASSERT_EQ(rmq_solver.ans_query({i, j}), sparse.min({i, j}));
+      }
+    }
+    // the levels and the block types the queries needed are built by now
+    auto after = rmq_solver.memory_usage();
+    auto estimate = solver::estimate_memory(size, rmq_solver.block_size());
+    for (auto &&[name, bytes] : estimate.parts()) {
+      ASSERT_LE(before[name], after[name]);
+      ASSERT_LE(after[name], bytes);
+    }
+    // the queries built the levels above the first one
+    if (size >= 100) {
+      ASSERT_LT(before["block sparse table"], after["block sparse table"]);
+    }
+  }
+}
+
+TEST(RMQ, Lazy2) {
+  using solver = RmqSolver<int, std::allocator<int>, LazyBlockSparseTable>;
+  std::mt19937 engine {std::random_device{}()};
+  std::vector<int> v(100000);
+  std::generate(v.begin(), v.end(), [&] { return static_cast<int>(engine()); });
+  std::uniform_int_distribution<std::size_t> index(0, v.size() - 1);
+  std::vector<std::pair<std::size_t, std::size_t>> queries(100000);
+  for (auto &&[l, r] : queries) {
+    l = index(engine), r = index(engine);
+  }
+  RmqSolver eager(v.begin(), v.end());
+  // the levels are built by concurrent queries
+  solver lazy(v.begin(), v.end());
+  ASSERT_EQ(ans_queries(lazy, queries, 8), ans_queries(eager, queries, 1));
+}
+
+TEST(RMQ, Small1) {
+  using solver = RmqSolver<int>;
+  using Shape  = solver::Shape;
+  for (std::size_t size : {std::size_t{1}, solver::scan_size, solver::scan_size + 1,
+                           solver::sparse_size, solver::sparse_size + 1}) {
+    std::vector<int> v(size);
+    std::generate(v.begin(), v.end(), [] { return dice(-1000, 1000); });
+    SparseTable sparse(v.begin(), v.end(), v.size());
+    auto expected = (size <= solver::scan_size   ? Shape::scan :
+                     size <= solver::sparse_size ? Shape::sparse_table : Shape::blocks);
+    for (std::size_t block_sz : {solver::theoretical_block_size, solver::auto_block_size,
+                                 std::size_t{3}}) {
+      solver rmq_solver(v.begin(), v.end(), block_sz);
+      // an explicit block size always takes the blocks
+      ASSERT_EQ(rmq_solver.shape(), block_sz == 3 ? Shape::blocks : expected);
+      ASSERT_EQ(rmq_solver.block_size(), solver::choose_block_size(size, block_sz));
+      for (std::size_t i = 0; i < size; i += 13) {
+        for (std::size_t j = i; j < size; j += 3) {
+          ASSERT_EQ(rmq_solver.ans_query({j, i}), sparse.min({i, j}));
+        }
+      }
+      ASSERT_EQ(rmq_solver.memory_usage().parts(),
+                solver::estimate_memory(size, block_sz).parts());
+    }
+  }
+  // the size of an input range is unknown
+  std::istringstream is {"3 1 2"};
+  solver rmq_solver(std::istream_iterator<int>{is}, std::istream_iterator<int>{});
+  ASSERT_EQ(rmq_solver.shape(), Shape::blocks);
+  ASSERT_EQ(rmq_solver.ans_query({0, 2}), 1);
+}
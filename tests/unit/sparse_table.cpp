@@ -2,6 +2,8 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <array>
+#include <memory>
 
 #include "sparse_table.hpp"
 
@@ -54,3 +56,29 @@ TEST(SparseTable, Sparse3) {
   }
 }
 
+
+TEST(SparseTable, Memory1) {
+  for (std::size_t size : {1, 2, 1000, 1025}) {
+    std::vector<int> array(size, 1);
+    SparseTable sparse_t(array.cbegin(), array.cend(), array.size());
+    ASSERT_EQ(sparse_t.memory_usage().parts(),
+              SparseTable<int>::estimate_memory(size).parts());
+  }
+}
+
+TEST(SparseTable, Static1) {
+  static constexpr StaticSparseTable table {std::array {5, 3, 8, -2, 7, 7, 0, 4, 1}};
+  static_assert(table.size() == 9 && table.rows_num == 4);
+  static_assert(table.min({0, 1}) == 3 && table.min({0, 8}) == -2 &&
+                table.min({4, 8}) == 0 && table.ans_query({8, 7}) == 1);
+
+  std::vector array(1000, 0);
+  std::generate(array.begin(), array.end(), [] { return dice(-1, 1000); });
+  auto static_t = std::make_unique<StaticSparseTable<int, 1000>>(array.begin(), array.end());
+  SparseTable sparse_t(array.cbegin(), array.cend(), array.size());
+  for (std::size_t i = 0; i < array.size(); i += 3) {
+    for (std::size_t j = i; j < array.size(); ++j) {
+      ASSERT_EQ(static_t->min({i, j}), sparse_t.min({i, j}));
+    }
+  }
+}
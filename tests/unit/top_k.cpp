@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <utility>
+
+#include "top_k.hpp"
+
+using namespace yLAB;
+
+namespace {
+
+  std::mt19937 engine {std::random_device{}()};
+
+  // k smallest (value, position) of [l, r] by sorting
+  std::vector<std::pair<int, std::size_t>> naive_top_k(const std::vector<int> &v,
+                                                       std::size_t l, std::size_t r,
+                                                       std::size_t k) {
+    std::vector<std::pair<int, std::size_t>> elements;
+    for (auto id = l; id <= r; ++id) {
+      elements.emplace_back(v[id], id);
+    }
+    std::sort(elements.begin(), elements.end());
+    elements.resize(std::min(k, elements.size()));
+    return elements;
+  }
+
+} // <--- namespace
+
+TEST(TopK, TopK1) {
+  std::vector<int> v {5, 1, 4, 1, 5, 9, 2, 6};
+  RangeTopK top(v.begin(), v.end());
+  using elements = std::vector<std::pair<int, std::size_t>>;
+  ASSERT_EQ(top.top_k({0, 7}, 3), (elements {{1, 1}, {1, 3}, {2, 6}}));
+  ASSERT_EQ(top.top_k({7, 4}, 2), (elements {{2, 6}, {5, 4}}));
+  ASSERT_EQ(top.top_k({2, 2}, 5), (elements {{4, 2}}));
+  ASSERT_TRUE(top.top_k({0, 7}, 0).empty());
+  ASSERT_EQ(top.min_element({4, 7}), std::make_pair(2, std::size_t{6}));
+  ASSERT_EQ(top.ans_query({0, 2}), 1);
+}
+
+TEST(TopK, TopK2) {
+  for (std::size_t size : {1, 7, 300, 10000}) {
+    std::vector<int> v(size);
+    // many equal values
+    std::generate(v.begin(), v.end(), [] { return static_cast<int>(engine() % 50); });
+    RangeTopK top(v.begin(), v.end());
+
+    std::vector<std::pair<std::size_t, std::size_t>> queries(500);
+    for (auto &&[l, r] : queries) {
+      l = engine() % size, r = engine() % size;
+    }
+    for (std::size_t k : {1, 2, 10, 100}) {
+      auto batch = top.top_k(queries, k, 3);
+      ASSERT_EQ(batch.size(), queries.size());
+      for (std::size_t id = 0; id < queries.size(); ++id) {
+        auto [l, r] = std::minmax(queries[id].first, queries[id].second);
+        auto expected = naive_top_k(v, l, r, k);
+        ASSERT_EQ(top.top_k(queries[id], k), expected);
+        ASSERT_EQ(batch[id], expected);
+      }
+    }
+  }
+}